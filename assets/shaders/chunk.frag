@@ -1,10 +1,20 @@
 #version 450 core
 out vec4 outputColor;
 in vec2 TexCoord;
+flat in vec2 Tile;
+in float Shade; // 0..1 from the sky/block light baked into the vertex
 
 uniform sampler2D ourTexture;
 
+const float TILE_STEP = 1.0 / 16.0; // 16x16 atlas
+
 void main()
 {
-    outputColor = texture(ourTexture, TexCoord);
-}
\ No newline at end of file
+    // repeat the tile across greedy merged quads
+    vec2 atlasUV = (Tile + fract(TexCoord)) * TILE_STEP;
+
+    // gradients from the unwrapped coords so fract() seams dont pick the smallest mip
+    vec2 gradUV = TexCoord * TILE_STEP;
+    outputColor = textureGrad(ourTexture, atlasUV, dFdx(gradUV), dFdy(gradUV));
+    outputColor.rgb *= Shade;
+}
@@ -1,15 +1,45 @@
 #version 450 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
+// packed vertex, see src/ChunkVertex.h
+// bits: 0-5 x | 6-11 y | 12-17 z | 18-20 face | 21-22 corner | 23-30 atlas tile
+layout (location = 0) in uint aData;
+// world position of the chunk's (0,0,0) corner + blocks per mesh unit (lod scale), one per draw (see src/ChunkMeshArena.h)
+layout (location = 1) in vec4 aChunkOrigin;
+// light bits: 0-3 sky light | 4-7 block light | 8-9 ambient occlusion
+layout (location = 2) in uint aLight;
 
 out vec2 TexCoord;
+flat out vec2 Tile;
+out float Shade;
+
+// each light level below 15 darkens by this factor, level 0 keeps a little so caves arent pitch black
+const float LIGHT_FALLOFF = 0.8;
+// corner brightness per ambient occlusion level, 0 = boxed in by 2 blocks, 3 = open
+const float AO_LEVELS[4] = float[](0.5, 0.7, 0.85, 1.0);
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    TexCoord = aTexCoord;
-}
\ No newline at end of file
+    vec3 pos = vec3(aData & 63u, (aData >> 6) & 63u, (aData >> 12) & 63u);
+    uint face = (aData >> 18) & 7u;
+    uint tile = (aData >> 23) & 255u;
+
+    gl_Position = projection * view * vec4(aChunkOrigin.xyz + pos * aChunkOrigin.w, 1.0);
+
+    // texture coords in tiles from the face plane, keeps the old cube UV orientation
+    // in mesh units, so a lod cell shows one stretched tile
+    // face index map: 0=front, 1=back, 2=left, 3=right, 4=top, 5=bottom
+    if (face == 0u)      TexCoord = vec2( pos.x, pos.y);
+    else if (face == 1u) TexCoord = vec2(-pos.x, pos.y);
+    else if (face == 2u) TexCoord = vec2( pos.z, pos.y);
+    else if (face == 3u) TexCoord = vec2(-pos.z, pos.y);
+    else if (face == 4u) TexCoord = vec2( pos.x, -pos.z);
+    else                 TexCoord = vec2( pos.x, pos.z);
+
+    Tile = vec2(tile & 15u, tile >> 4);
+
+    float sky = float(aLight & 15u);
+    float block = float((aLight >> 4) & 15u);
+    Shade = pow(LIGHT_FALLOFF, 15.0 - max(sky, block)) * AO_LEVELS[(aLight >> 8) & 3u];
+}
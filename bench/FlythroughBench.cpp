@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Camera.h"
+#include "EntityStore.h"
+#include "MicroBenchmarks.h"
+#include "Physics.h"
+#include "VoxelWorld.h"
+
+// headless flythrough, the CPU side of every frame with no window and no GL context (built with VOXEL_HEADLESS)
+// a camera flies a fixed path over the terrain while a walking player follows it on the ground
+// each frame runs the stages of main's loop, timed one by one:
+//   physics  - the player's fixed ticks
+//   entities - the entity store's fixed ticks
+//   interact - the crosshair raycast, plus a block edit every EDIT_INTERVAL frames
+//   update   - column streaming, lod changes, mesh scheduling and arena placement (world.update)
+//   cull     - frustum and occlusion traversal building the draw list (world.render)
+// prints p50/p95/p99 per stage and chunks/s, and writes the same as json to diff between commits
+// after the flight, micro benchmarks (MicroBenchmarks.h) run on the chunks nearest where it ended:
+//   storage  - get/set on palette packed BlockStorage vs a flat array
+//   meshers  - naive, greedy and binary on the same padded chunks, ambient occlusion off and on
+//   raycast  - random rays from where the walking player ended up, batched and one at a time
+//   entities - 1k/10k/100k entity stores ticking on the ground around the player
+//
+// usage: VoxelBench [--frames n] [--threads n] [--out report.json]
+// VOXEL_THREADS=n works like in the game, --threads wins over it
+
+// same view as main, so culling sees what a real frame sees
+const unsigned int SCR_WIDTH = 1280;
+const unsigned int SCR_HEIGHT = 720;
+const int RENDER_DISTANCE = 24;
+const float FAR_PLANE = RENDER_DISTANCE * CHUNK_SIZE * 1.5f;
+// every frame moves the simulation on by this much, the path is the same however fast the machine is
+const float FRAME_TIME = 1.0f / 60.0f;
+const int DEFAULT_FRAMES = 1800;
+
+// path: along +x at FLY_SPEED blocks/s weaving in z, at a fixed height looking down ahead
+// only depends on time, never on what has loaded yet
+const glm::vec3 START = glm::vec3(16.0f, 120.0f, 40.0f);
+const float FLY_SPEED = 20.0f;
+const float WEAVE_AMPLITUDE = 48.0f;
+const float WEAVE_PERIOD = 20.0f; // seconds
+const float LOOK_DOWN = 0.35f;    // direction y per block forward
+
+// the player walks after the camera, and is put back under it when left this far behind
+const float WALK_SPEED = 8.0f;
+const float WALK_CATCH_UP = 64.0f;
+const int JUMP_INTERVAL = 30;
+const float REACH = 8.0f;
+// breaks the block under the crosshair, then puts glowstone in front of the next one, and so on
+const int EDIT_INTERVAL = 20;
+
+// dropped around the player and dropped again there every ENTITY_INTERVAL frames, so they stay on loaded ground
+const int ENTITY_COUNT = 2000;
+const int ENTITY_INTERVAL = 600;
+const float ENTITY_SPREAD = 32.0f;
+
+// chunks the micro benchmarks run on
+const size_t MICRO_BENCHMARK_CHUNKS = 64;
+const size_t RAYCAST_RAYS = 100000;
+const float RAYCAST_DISTANCE = 64.0f;
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Stage
+{
+    const char* name;
+    std::vector<double> samples; // ms, one per frame
+};
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// nearest rank, sorted has to be sorted
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::clamp(rank, (size_t)1, sorted.size()) - 1];
+}
+
+static glm::vec3 pathPosition(float time)
+{
+    float phase = time * 2.0f * glm::pi<float>() / WEAVE_PERIOD;
+    return START + glm::vec3(FLY_SPEED * time, 0.0f, WEAVE_AMPLITUDE * std::sin(phase));
+}
+
+static glm::vec3 pathDirection(float time)
+{
+    float phase = time * 2.0f * glm::pi<float>() / WEAVE_PERIOD;
+    float dz = WEAVE_AMPLITUDE * std::cos(phase) * 2.0f * glm::pi<float>() / WEAVE_PERIOD;
+    glm::vec3 forward = glm::normalize(glm::vec3(FLY_SPEED, 0.0f, dz));
+    return glm::normalize(forward + glm::vec3(0.0f, -LOOK_DOWN, 0.0f));
+}
+
+static void dropEntities(EntityStore& entities, const VoxelWorld& world, glm::vec3 center, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> spread(-ENTITY_SPREAD, ENTITY_SPREAD);
+    std::uniform_real_distribution<float> drop(2.0f, 16.0f);
+
+    entities.clear();
+    for (int i = 0; i < ENTITY_COUNT; i++)
+    {
+        glm::vec3 position(center.x + spread(rng), 0.0f, center.z + spread(rng));
+        int ground = world.getSurfaceHeight((int)std::floor(position.x), (int)std::floor(position.z));
+        position.y = (float)(ground + 1) + drop(rng);
+
+        // a mob every 4th, items otherwise, as in benchmarkEntities
+        glm::vec3 half = i % 4 == 0 ? glm::vec3(0.3f, 0.9f, 0.3f) : glm::vec3(0.125f);
+        entities.spawn(position, half);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int frames = DEFAULT_FRAMES;
+    const char* threadsEnv = std::getenv("VOXEL_THREADS");
+    unsigned int threads = threadsEnv ? (unsigned int)std::atoi(threadsEnv) : 0;
+    std::string reportPath = "bench_report.json";
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cout << "missing value for " << option << std::endl;
+            return 1;
+        }
+        if (option == "--frames") frames = std::max(1, std::atoi(argv[++i]));
+        else if (option == "--threads") threads = (unsigned int)std::atoi(argv[++i]);
+        else if (option == "--out") reportPath = argv[++i];
+        else
+        {
+            std::cout << "unknown option " << option << ", usage: VoxelBench [--frames n] [--threads n] [--out report.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    // nothing from disk, every run starts from the same freshly generated world
+    VoxelWorld world(threads, "");
+
+    auto startupStart = Clock::now();
+    world.generateAround(START);
+    double startupMs = millisecondsSince(startupStart);
+    size_t startupChunks = world.getInsertedChunkCount();
+
+    Camera player(START);
+    player.flying_mode = false;
+    Physics physics;
+    physics.respawn(world, player);
+
+    TaskScheduler entityThreads;
+    EntityStore entities(entityThreads);
+    std::mt19937 rng(1);
+
+    glm::mat4 projection = glm::perspective(glm::radians(ZOOM), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+
+    std::vector<Stage> stages = { { "physics", {} }, { "entities", {} }, { "interact", {} }, { "update", {} }, { "cull", {} }, { "frame", {} } };
+    for (Stage& stage : stages) stage.samples.reserve(frames);
+
+    size_t columnsBefore = world.getInsertedColumnCount();
+    size_t chunksBefore = world.getInsertedChunkCount();
+    size_t meshesBefore = world.getUploadedMeshCount();
+    size_t visibleTotal = 0;
+    size_t editsDone = 0;
+    bool placeNext = false;
+
+    std::cout << "flying " << frames << " frames (" << frames * FRAME_TIME << " s of game time) headless..." << std::endl;
+    auto runStart = Clock::now();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        float time = frame * FRAME_TIME;
+        glm::vec3 eye = pathPosition(time);
+        glm::vec3 front = pathDirection(time);
+        // bench setup, not part of any frame
+        if (frame % ENTITY_INTERVAL == 0) dropEntities(entities, world, player.Position, rng);
+        auto frameStart = Clock::now();
+
+        // player input, what processInput would have done
+        glm::vec3 toCamera = glm::vec3(eye.x - player.Position.x, 0.0f, eye.z - player.Position.z);
+        if (glm::length(toCamera) > WALK_CATCH_UP)
+        {
+            player.Position = glm::vec3(eye.x, player.Position.y, eye.z);
+            physics.respawn(world, player);
+        }
+        else physics.move(toCamera, WALK_SPEED);
+        if (frame % JUMP_INTERVAL == 0) physics.jump();
+
+        auto start = Clock::now();
+        physics.step(FRAME_TIME, world, player);
+        stages[0].samples.push_back(millisecondsSince(start));
+
+        start = Clock::now();
+        entities.step(FRAME_TIME, world);
+        stages[1].samples.push_back(millisecondsSince(start));
+
+        // cast where main does, edits land before the next update like clicks do
+        start = Clock::now();
+        glm::vec3 look = glm::normalize(glm::vec3(toCamera.x, -glm::length(toCamera) * LOOK_DOWN - 1.0f, toCamera.z));
+        RaycastResult target = physics.raycast(player.Position, look, REACH, world);
+        if (target.hit && frame % EDIT_INTERVAL == 0)
+        {
+            if (placeNext)
+            {
+                glm::ivec3 at = glm::ivec3(target.x, target.y, target.z) + glm::ivec3(target.normal);
+                world.setBlock(at.x, at.y, at.z, GLOWSTONE);
+            }
+            else world.setBlock(target.x, target.y, target.z, 0);
+            placeNext = !placeNext;
+            editsDone++;
+        }
+        stages[2].samples.push_back(millisecondsSince(start));
+
+        start = Clock::now();
+        world.update(eye);
+        stages[3].samples.push_back(millisecondsSince(start));
+
+        start = Clock::now();
+        glm::mat4 view = glm::lookAt(eye, eye + front, glm::vec3(0.0f, 1.0f, 0.0f));
+        world.render(projection * view, eye, RENDER_DISTANCE);
+        stages[4].samples.push_back(millisecondsSince(start));
+        visibleTotal += world.getVisibleChunkCount();
+
+        stages[5].samples.push_back(millisecondsSince(frameStart));
+    }
+
+    double runSeconds = millisecondsSince(runStart) / 1000.0;
+    size_t columns = world.getInsertedColumnCount() - columnsBefore;
+    size_t chunks = world.getInsertedChunkCount() - chunksBefore;
+    size_t meshes = world.getUploadedMeshCount() - meshesBefore;
+
+    // report
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::left << std::setw(10) << "stage" << std::right << std::setw(10) << "mean ms" << std::setw(10) << "p50"
+              << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+
+    std::ofstream json(reportPath);
+    json << std::fixed << std::setprecision(4);
+    json << "{\n";
+    json << "  \"frames\": " << frames << ",\n";
+    json << "  \"frame_time_s\": " << FRAME_TIME << ",\n";
+    json << "  \"worker_threads\": " << world.getWorkerThreadCount() << ",\n";
+    json << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    json << "  \"load_radius\": " << world.loadRadius << ",\n";
+    json << "  \"render_distance\": " << RENDER_DISTANCE << ",\n";
+    json << "  \"seed\": " << world.seed << ",\n";
+    json << "  \"stages_ms\": {\n";
+
+    for (size_t s = 0; s < stages.size(); s++)
+    {
+        std::vector<double> sorted = stages[s].samples;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0.0;
+        for (double sample : sorted) mean += sample;
+        mean /= sorted.size();
+        double p50 = percentile(sorted, 0.50);
+        double p95 = percentile(sorted, 0.95);
+        double p99 = percentile(sorted, 0.99);
+
+        std::cout << std::left << std::setw(10) << stages[s].name << std::right << std::setw(10) << mean << std::setw(10) << p50
+                  << std::setw(10) << p95 << std::setw(10) << p99 << std::setw(10) << sorted.back() << std::endl;
+        json << "    \"" << stages[s].name << "\": { \"mean\": " << mean << ", \"p50\": " << p50 << ", \"p95\": " << p95
+             << ", \"p99\": " << p99 << ", \"max\": " << sorted.back() << " }" << (s + 1 < stages.size() ? "," : "") << "\n";
+    }
+    json << "  },\n";
+
+    double chunksPerSecond = chunks / runSeconds;
+    double meshesPerSecond = meshes / runSeconds;
+    double startupChunksPerSecond = startupMs > 0.0 ? startupChunks / (startupMs / 1000.0) : 0.0;
+    std::cout << std::setprecision(1);
+    std::cout << "startup: " << startupChunks << " chunks in " << startupMs << " ms (" << startupChunksPerSecond << " chunks/s)" << std::endl;
+    std::cout << "streaming: " << columns << " columns, " << chunks << " chunks (" << chunksPerSecond << " chunks/s), "
+              << meshes << " meshes (" << meshesPerSecond << " meshes/s) in " << runSeconds << " s" << std::endl;
+    std::cout << "culling: " << visibleTotal / frames << " chunks visible per frame on average | edits: " << editsDone << std::endl;
+
+    glm::vec3 end = pathPosition((frames - 1) * FRAME_TIME);
+    std::cout << std::setprecision(3);
+    std::vector<ChunkCoord> benchmarkChunks = findBenchmarkChunks(world, end, MICRO_BENCHMARK_CHUNKS);
+    StorageBenchmark storage = benchmarkBlockStorage(world, benchmarkChunks);
+    MesherBenchmark meshers = benchmarkMeshers(world, benchmarkChunks);
+    RaycastBenchmark rays = benchmarkRaycast(world, player.Position, RAYCAST_DISTANCE, RAYCAST_RAYS);
+    EntityBenchmark entityStores = benchmarkEntities(world, entityThreads, player.Position);
+
+    json << "  \"startup\": { \"ms\": " << startupMs << ", \"chunks\": " << startupChunks << ", \"chunks_per_s\": " << startupChunksPerSecond << " },\n";
+    json << "  \"streaming\": { \"seconds\": " << runSeconds << ", \"columns\": " << columns << ", \"chunks\": " << chunks
+         << ", \"chunks_per_s\": " << chunksPerSecond << ", \"meshes\": " << meshes << ", \"meshes_per_s\": " << meshesPerSecond << " },\n";
+    json << "  \"visible_chunks_avg\": " << visibleTotal / frames << ",\n";
+    json << "  \"edits\": " << editsDone << ",\n";
+
+    auto accessJson = [](const BlockAccessTimings& timings)
+    {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(4) << "{ \"get_in_order\": " << timings.sequentialGet << ", \"get_random\": " << timings.randomGet
+            << ", \"set_in_order\": " << timings.sequentialSet << ", \"set_random\": " << timings.randomSet << " }";
+        return out.str();
+    };
+    json << "  \"storage_ns\": { \"chunks\": " << storage.chunks << ", \"matched\": " << (storage.matched ? "true" : "false")
+         << ",\n    \"palette\": " << accessJson(storage.palette) << ",\n    \"array\": " << accessJson(storage.array) << " },\n";
+
+    auto mesherJson = [](const MesherTimings& timings)
+    {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(4) << "{ \"plain\": " << timings.plain << ", \"ao\": " << timings.ambientOcclusion
+            << ", \"quads\": " << timings.quads << ", \"quads_ao\": " << timings.quadsAO << " }";
+        return out.str();
+    };
+    json << "  \"mesher_us\": { \"chunks\": " << meshers.chunks << ", \"matched\": " << (meshers.matched ? "true" : "false")
+         << ",\n    \"naive\": " << mesherJson(meshers.naive) << ",\n    \"greedy\": " << mesherJson(meshers.greedy)
+         << ",\n    \"binary\": " << mesherJson(meshers.binary) << " },\n";
+    json << "  \"raycast\": { \"rays\": " << rays.rays << ", \"hits\": " << rays.hits << ", \"steps\": " << rays.steps
+         << ", \"batched_ms\": " << rays.batchedMs << ", \"rays_per_s\": " << rays.raysPerSecond << ", \"steps_per_s\": " << rays.stepsPerSecond
+         << ", \"single_ms\": " << rays.singleMs << ", \"single_rays_per_s\": " << rays.singleRaysPerSecond << " },\n";
+    json << "  \"entities\": { \"ticks\": " << entityStores.ticks;
+    for (const EntityTimings& timings : entityStores.stores)
+    {
+        json << ",\n    \"" << timings.count << "\": { \"entities_per_ms\": " << timings.entitiesPerMs << ", \"ms_per_tick\": " << timings.msPerTick
+             << ", \"contacts\": " << timings.contacts << " }";
+    }
+    json << " }\n";
+    json << "}\n";
+
+    if (!json)
+    {
+        std::cout << "failed to write " << reportPath << std::endl;
+        return 1;
+    }
+    std::cout << "report written to " << reportPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,401 @@
+#include "MicroBenchmarks.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include "BlockStorage.h"
+
+std::vector<ChunkCoord> findBenchmarkChunks(const VoxelWorld& world, glm::vec3 center, size_t count)
+{
+    // x,z in columns, isColumnLoaded takes blocks
+    auto columnLoaded = [&](int x, int z) { return world.isColumnLoaded(x * CHUNK_SIZE, z * CHUNK_SIZE); };
+
+    glm::vec3 centerSection = center / (float)CHUNK_SIZE;
+    std::vector<std::pair<float, ChunkCoord>> candidates;
+    for (ChunkCoord coord : world.getChunkCoords())
+    {
+        const Chunk* chunk = world.getChunk(coord);
+        if (chunk->isUniform() || !columnLoaded(coord.x, coord.z)) continue;
+        if (!columnLoaded(coord.x - 1, coord.z) || !columnLoaded(coord.x + 1, coord.z)
+            || !columnLoaded(coord.x, coord.z - 1) || !columnLoaded(coord.x, coord.z + 1)) continue;
+        glm::vec3 offset = glm::vec3(coord.x + 0.5f, coord.y + 0.5f, coord.z + 0.5f) - centerSection;
+        candidates.emplace_back(glm::dot(offset, offset), coord);
+    }
+
+    // ties broken by coord, the pick doesnt depend on the hash map's order
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b)
+    {
+        return std::tie(a.first, a.second.x, a.second.y, a.second.z) < std::tie(b.first, b.second.x, b.second.y, b.second.z);
+    });
+
+    std::vector<ChunkCoord> coords;
+    for (size_t i = 0; i < candidates.size() && i < count; i++) coords.push_back(candidates[i].second);
+    return coords;
+}
+
+StorageBenchmark benchmarkBlockStorage(const VoxelWorld& world, const std::vector<ChunkCoord>& coords)
+{
+    const int REPEATS = 8;
+    using FlatBlocks = std::array<BlockID, CHUNK_VOLUME>;
+
+    StorageBenchmark result;
+    result.chunks = coords.size();
+    if (coords.empty())
+    {
+        std::cout << "storage: no loaded chunks to benchmark" << std::endl;
+        return result;
+    }
+
+    // the same blocks three times: packed, flat, and flat moved down a layer for the writes
+    // writes alternate between the two flat sources every repeat so each one changes the block,
+    // every value is already in the chunk's palette, nothing repacks because of a new type
+    std::vector<BlockStorage> palettes;
+    palettes.reserve(coords.size());
+    std::vector<FlatBlocks> arrays(coords.size());
+    std::vector<FlatBlocks> originals(coords.size());
+    std::vector<FlatBlocks> shifted(coords.size());
+    size_t bitTotal = 0;
+    for (size_t c = 0; c < coords.size(); c++)
+    {
+        world.getChunk(coords[c])->copyBlocks(originals[c].data());
+        for (size_t i = 0; i < CHUNK_VOLUME; i++) shifted[c][i] = originals[c][(i + CHUNK_SIZE * CHUNK_SIZE) % CHUNK_VOLUME];
+        arrays[c] = originals[c];
+        palettes.emplace_back(CHUNK_VOLUME);
+        palettes.back().assign(originals[c].data());
+        bitTotal += palettes.back().getBitsPerBlock();
+    }
+
+    // one shuffled order for both, a random pass still touches every cell once
+    std::vector<uint32_t> randomOrder(CHUNK_VOLUME);
+    std::iota(randomOrder.begin(), randomOrder.end(), 0);
+    std::shuffle(randomOrder.begin(), randomOrder.end(), std::mt19937(1));
+
+    double accesses = (double)coords.size() * CHUNK_VOLUME * REPEATS;
+    auto nsPerAccess = [accesses](const auto& pass)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int repeat = 0; repeat < REPEATS; repeat++) pass(repeat);
+        return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / accesses;
+    };
+    auto source = [&](size_t c, int repeat) -> const FlatBlocks& { return repeat % 2 == 0 ? shifted[c] : originals[c]; };
+
+    // sums keep the reads from being optimized away, and have to agree
+    uint64_t paletteSum = 0;
+    uint64_t arraySum = 0;
+
+    result.palette.sequentialGet = nsPerAccess([&](int)
+    {
+        for (const BlockStorage& blocks : palettes)
+        {
+            for (size_t i = 0; i < CHUNK_VOLUME; i++) paletteSum += blocks.get(i);
+        }
+    });
+    result.array.sequentialGet = nsPerAccess([&](int)
+    {
+        for (const FlatBlocks& blocks : arrays)
+        {
+            for (size_t i = 0; i < CHUNK_VOLUME; i++) arraySum += blocks[i];
+        }
+    });
+    result.palette.randomGet = nsPerAccess([&](int)
+    {
+        for (const BlockStorage& blocks : palettes)
+        {
+            for (uint32_t i : randomOrder) paletteSum += blocks.get(i);
+        }
+    });
+    result.array.randomGet = nsPerAccess([&](int)
+    {
+        for (const FlatBlocks& blocks : arrays)
+        {
+            for (uint32_t i : randomOrder) arraySum += blocks[i];
+        }
+    });
+    result.palette.sequentialSet = nsPerAccess([&](int repeat)
+    {
+        for (size_t c = 0; c < palettes.size(); c++)
+        {
+            const FlatBlocks& values = source(c, repeat);
+            for (size_t i = 0; i < CHUNK_VOLUME; i++) palettes[c].set(i, values[i]);
+        }
+    });
+    result.array.sequentialSet = nsPerAccess([&](int repeat)
+    {
+        for (size_t c = 0; c < arrays.size(); c++)
+        {
+            const FlatBlocks& values = source(c, repeat);
+            for (size_t i = 0; i < CHUNK_VOLUME; i++) arrays[c][i] = values[i];
+        }
+    });
+    result.palette.randomSet = nsPerAccess([&](int repeat)
+    {
+        for (size_t c = 0; c < palettes.size(); c++)
+        {
+            const FlatBlocks& values = source(c, repeat);
+            for (uint32_t i : randomOrder) palettes[c].set(i, values[i]);
+        }
+    });
+    result.array.randomSet = nsPerAccess([&](int repeat)
+    {
+        for (size_t c = 0; c < arrays.size(); c++)
+        {
+            const FlatBlocks& values = source(c, repeat);
+            for (uint32_t i : randomOrder) arrays[c][i] = values[i];
+        }
+    });
+
+    FlatBlocks unpacked;
+    result.matched = paletteSum == arraySum;
+    for (size_t c = 0; c < coords.size() && result.matched; c++)
+    {
+        palettes[c].unpack(unpacked.data());
+        result.matched = unpacked == arrays[c];
+    }
+
+    std::cout << "storage: " << coords.size() << " chunks, " << (double)bitTotal / coords.size() << " bits per block on average, "
+              << REPEATS << " passes each | ns per access, palette vs array" << std::endl;
+    std::cout << "  get in order " << result.palette.sequentialGet << " vs " << result.array.sequentialGet
+              << " | get random " << result.palette.randomGet << " vs " << result.array.randomGet
+              << " | set in order " << result.palette.sequentialSet << " vs " << result.array.sequentialSet
+              << " | set random " << result.palette.randomSet << " vs " << result.array.randomSet << std::endl;
+    if (!result.matched) std::cout << "storage: palette and array DISAGREE" << std::endl;
+    return result;
+}
+
+// one quad as face, tile, light and corner levels (27 bits) followed by min and max of its box on every axis (6 bits each)
+// the same whichever corner a mesher starts it at and wherever it sits in the buffer
+static uint64_t quadKey(uint64_t attributes, const int minPos[3], const int maxPos[3])
+{
+    uint64_t key = attributes;
+    for (int axis = 0; axis < 3; axis++) key = (key << 12) | ((uint64_t)minPos[axis] << 6) | (uint64_t)maxPos[axis];
+    return key;
+}
+
+static uint64_t decodeQuad(const PackedVertex* quad, int minPos[3], int maxPos[3])
+{
+    VertexAttributes first = unpackVertex(quad[0]);
+    uint64_t levels = 0;
+    for (int axis = 0; axis < 3; axis++) minPos[axis] = maxPos[axis] = (&first.x)[axis];
+    for (int i = 0; i < 4; i++)
+    {
+        VertexAttributes v = unpackVertex(quad[i]);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            minPos[axis] = std::min(minPos[axis], (&v.x)[axis]);
+            maxPos[axis] = std::max(maxPos[axis], (&v.x)[axis]);
+        }
+        levels |= (uint64_t)v.ao << (v.corner * 2);
+    }
+    return (uint64_t)first.face | ((uint64_t)first.tile << 3) | ((uint64_t)first.skyLight << 11)
+           | ((uint64_t)first.blockLight << 15) | (levels << 19);
+}
+
+// every quad of a mesh, sorted, two meshers agree when these are equal
+static std::vector<uint64_t> sortedQuads(const std::vector<PackedVertex>& vertices)
+{
+    std::vector<uint64_t> keys;
+    keys.reserve(vertices.size() / 4);
+    for (size_t i = 0; i + 4 <= vertices.size(); i += 4)
+    {
+        int minPos[3], maxPos[3];
+        uint64_t attributes = decodeQuad(&vertices[i], minPos, maxPos);
+        keys.push_back(quadKey(attributes, minPos, maxPos));
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+// every quad cut into the 1x1 faces it covers, sorted, so a merged mesh compares against the naive one
+// merged faces have matching corners (see ChunkMesher), each piece keeps the quad's corner levels
+static std::vector<uint64_t> sortedUnitFaces(const std::vector<PackedVertex>& vertices)
+{
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i + 4 <= vertices.size(); i += 4)
+    {
+        int minPos[3], maxPos[3];
+        uint64_t attributes = decodeQuad(&vertices[i], minPos, maxPos);
+
+        // the normal axis is the flat one, the other two are walked a block at a time
+        int normal = minPos[0] == maxPos[0] ? 0 : (minPos[1] == maxPos[1] ? 1 : 2);
+        int u = (normal + 1) % 3;
+        int v = (normal + 2) % 3;
+
+        int unitMin[3] = { minPos[0], minPos[1], minPos[2] };
+        int unitMax[3] = { maxPos[0], maxPos[1], maxPos[2] };
+        for (int a = minPos[u]; a < maxPos[u]; a++)
+        {
+            for (int b = minPos[v]; b < maxPos[v]; b++)
+            {
+                unitMin[u] = a;
+                unitMax[u] = a + 1;
+                unitMin[v] = b;
+                unitMax[v] = b + 1;
+                keys.push_back(quadKey(attributes, unitMin, unitMax));
+            }
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+MesherBenchmark benchmarkMeshers(const VoxelWorld& world, const std::vector<ChunkCoord>& coords)
+{
+    const int REPEATS = 5;
+    const MeshMode modes[3] = { MeshMode::Naive, MeshMode::Greedy, MeshMode::Binary };
+
+    MesherBenchmark result;
+    MesherTimings* timings[3] = { &result.naive, &result.greedy, &result.binary };
+    result.chunks = coords.size();
+    if (coords.empty())
+    {
+        std::cout << "meshers: no loaded chunks to benchmark" << std::endl;
+        return result;
+    }
+
+    // full size copies like a lod 0 request, every mesher gets the same input
+    std::vector<PaddedBlocks> padded(coords.size());
+    for (size_t c = 0; c < coords.size(); c++) world.copyPadded(coords[c], padded[c]);
+
+    // [mode][ambient occlusion][chunk], what the last pass built is kept for the checks
+    std::vector<std::vector<PackedVertex>> meshes[3][2];
+    for (int m = 0; m < 3; m++)
+    {
+        for (int ao = 0; ao < 2; ao++)
+        {
+            std::vector<std::vector<PackedVertex>>& built = meshes[m][ao];
+            built.resize(coords.size());
+
+            // best pass, a pass meshes every chunk once
+            double best = 0.0;
+            for (int repeat = 0; repeat < REPEATS; repeat++)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                for (size_t c = 0; c < coords.size(); c++)
+                {
+                    built[c].clear();
+                    buildChunkMesh(padded[c], modes[m], ao == 1, built[c]);
+                }
+                double us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+                if (repeat == 0 || us < best) best = us;
+            }
+
+            size_t quads = 0;
+            for (const std::vector<PackedVertex>& vertices : built) quads += vertices.size() / 4;
+            (ao == 1 ? timings[m]->ambientOcclusion : timings[m]->plain) = best / coords.size();
+            (ao == 1 ? timings[m]->quadsAO : timings[m]->quads) = quads;
+        }
+    }
+
+    for (int ao = 0; ao < 2 && result.matched; ao++)
+    {
+        for (size_t c = 0; c < coords.size() && result.matched; c++)
+        {
+            const std::vector<PackedVertex>& naive = meshes[0][ao][c];
+            const std::vector<PackedVertex>& greedy = meshes[1][ao][c];
+            const std::vector<PackedVertex>& binary = meshes[2][ao][c];
+            result.matched = sortedQuads(greedy) == sortedQuads(binary) && sortedUnitFaces(naive) == sortedUnitFaces(greedy);
+        }
+    }
+
+    std::cout << "meshers: " << coords.size() << " chunks, best of " << REPEATS << " passes | us per chunk, ao off / on (quads)" << std::endl;
+    const char* names[3] = { "naive", "greedy", "binary" };
+    for (int m = 0; m < 3; m++)
+    {
+        std::cout << (m == 0 ? "  " : " | ") << names[m] << " " << timings[m]->plain << " / " << timings[m]->ambientOcclusion
+                  << " (" << timings[m]->quads << " / " << timings[m]->quadsAO << ")";
+    }
+    std::cout << std::endl;
+    if (!result.matched) std::cout << "meshers: meshes DISAGREE" << std::endl;
+    return result;
+}
+
+RaycastBenchmark benchmarkRaycast(const VoxelWorld& world, glm::vec3 origin, float maxDist, size_t rayCount)
+{
+    // same directions every run, spread evenly over the sphere
+    std::mt19937 rng(1);
+    std::normal_distribution<float> gaussian;
+    std::vector<Ray> rays(rayCount);
+    for (Ray& ray : rays)
+    {
+        glm::vec3 direction(gaussian(rng), gaussian(rng), gaussian(rng));
+        ray = { origin, glm::normalize(direction), maxDist };
+    }
+    std::vector<RaycastResult> results(rayCount);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t steps = world.raycast(rays.data(), results.data(), rayCount);
+    auto batched = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < rayCount; i++) results[i] = world.raycast(rays[i]);
+    auto single = std::chrono::high_resolution_clock::now();
+
+    RaycastBenchmark result;
+    result.rays = rayCount;
+    result.hits = std::count_if(results.begin(), results.end(), [](const RaycastResult& r) { return r.hit; });
+    result.steps = steps;
+    double batchSeconds = std::chrono::duration<double>(batched - start).count();
+    double singleSeconds = std::chrono::duration<double>(single - batched).count();
+    result.batchedMs = batchSeconds * 1000.0;
+    result.singleMs = singleSeconds * 1000.0;
+    result.raysPerSecond = batchSeconds > 0.0 ? rayCount / batchSeconds : 0.0;
+    result.stepsPerSecond = batchSeconds > 0.0 ? steps / batchSeconds : 0.0;
+    result.singleRaysPerSecond = singleSeconds > 0.0 ? rayCount / singleSeconds : 0.0;
+
+    std::cout << "raycast: " << rayCount << " rays of " << maxDist << " blocks, " << result.hits << " hits, " << steps << " steps" << std::endl;
+    std::cout << "  batched: " << result.batchedMs << " ms, " << result.raysPerSecond / 1e6 << " M rays/s, "
+              << result.stepsPerSecond / 1e6 << " M steps/s" << std::endl;
+    std::cout << "  one at a time: " << result.singleMs << " ms, " << result.singleRaysPerSecond / 1e6 << " M rays/s" << std::endl;
+    return result;
+}
+
+EntityBenchmark benchmarkEntities(const VoxelWorld& world, TaskScheduler& scheduler, glm::vec3 center)
+{
+    const int TICKS = 120;
+    std::cout << "entities: " << TICKS << " ticks each, " << scheduler.getThreadCount() << " workers + main" << std::endl;
+
+    EntityBenchmark result;
+    result.ticks = TICKS;
+    for (size_t count : { (size_t)1000, (size_t)10000, (size_t)100000 })
+    {
+        EntityStore store(scheduler);
+        std::mt19937 rng(1);
+        // one entity per 2 blocks of ground at every count, so it measures scaling and not crowding
+        float radius = std::sqrt(count * 2.0f) * 0.5f;
+        std::uniform_real_distribution<float> spread(-radius, radius);
+        std::uniform_real_distribution<float> drop(2.0f, 48.0f);
+        for (size_t i = 0; i < count; i++)
+        {
+            // dropped over the ground, the first ticks are falls and the rest piling up and pushing apart
+            glm::vec3 position(center.x + spread(rng), 0.0f, center.z + spread(rng));
+            int ground = world.getSurfaceHeight((int)std::floor(position.x), (int)std::floor(position.z));
+            position.y = (float)(ground + 1) + drop(rng);
+
+            // a mob every 4th, items otherwise
+            glm::vec3 half = i % 4 == 0 ? glm::vec3(0.3f, 0.9f, 0.3f) : glm::vec3(0.125f);
+            store.spawn(position, half);
+        }
+
+        size_t updated = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < TICKS; t++)
+        {
+            updated += store.size();
+            store.tick(world);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        EntityTimings timings;
+        timings.count = count;
+        timings.entitiesPerMs = updated / ms;
+        timings.msPerTick = ms / TICKS;
+        timings.contacts = store.getContactCount();
+        result.stores.push_back(timings);
+
+        std::cout << "  " << count << ": " << timings.entitiesPerMs << " entities/ms, " << timings.msPerTick << " ms per tick, "
+                  << timings.contacts << " contacts in the last one" << std::endl;
+    }
+    return result;
+}
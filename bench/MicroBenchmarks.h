@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "EntityStore.h"
+#include "TaskScheduler.h"
+#include "VoxelWorld.h"
+
+// micro benchmarks VoxelBench runs after the flight, on a loaded world through its public accessors
+// each prints its numbers and returns them for the json report
+
+// ns per block access over the same chunks, see benchmarkBlockStorage
+struct BlockAccessTimings
+{
+    double sequentialGet = 0.0;
+    double randomGet = 0.0;
+    double sequentialSet = 0.0;
+    double randomSet = 0.0;
+};
+
+struct StorageBenchmark
+{
+    size_t chunks = 0;
+    BlockAccessTimings palette; // BlockStorage
+    BlockAccessTimings array;   // plain std::array of CHUNK_VOLUME blocks
+    bool matched = true;        // both read the same values and ended up holding the same blocks
+};
+
+// us per chunk for one mesher over the same padded chunks, see benchmarkMeshers
+struct MesherTimings
+{
+    double plain = 0.0;
+    double ambientOcclusion = 0.0;
+    size_t quads = 0;   // over all chunks, ambient occlusion off
+    size_t quadsAO = 0; // and on
+};
+
+struct MesherBenchmark
+{
+    size_t chunks = 0;
+    MesherTimings naive;
+    MesherTimings greedy;
+    MesherTimings binary;
+    // greedy and binary built the same quads, and naive the same faces one by one, with and without ambient occlusion
+    bool matched = true;
+};
+
+// rayCount random rays from one point, as one batch and one at a time, see benchmarkRaycast
+struct RaycastBenchmark
+{
+    size_t rays = 0;
+    size_t hits = 0;
+    size_t steps = 0; // walk steps of the batch
+    double batchedMs = 0.0;
+    double singleMs = 0.0;
+    double raysPerSecond = 0.0;       // batched
+    double stepsPerSecond = 0.0;      // batched
+    double singleRaysPerSecond = 0.0; // one VoxelWorld::raycast call per ray
+};
+
+// one store size in benchmarkEntities
+struct EntityTimings
+{
+    size_t count = 0;
+    double entitiesPerMs = 0.0; // entity updates per millisecond of ticking
+    double msPerTick = 0.0;
+    size_t contacts = 0; // overlapping pairs in the last tick
+};
+
+struct EntityBenchmark
+{
+    int ticks = 0;
+    std::vector<EntityTimings> stores; // 1k, 10k, 100k
+};
+
+// allocated, non uniform chunks of columns with all 4 neighbours loaded, nearest center first, at most count
+std::vector<ChunkCoord> findBenchmarkChunks(const VoxelWorld& world, glm::vec3 center, size_t count);
+
+// copies the chunks into BlockStorage and into plain arrays,
+// times in order and random order get/set over both and prints ns per access
+StorageBenchmark benchmarkBlockStorage(const VoxelWorld& world, const std::vector<ChunkCoord>& coords);
+
+// builds the chunks with every mesher, ambient occlusion off and on, from the same padded copies on this thread,
+// prints us per chunk and checks the meshes agree
+MesherBenchmark benchmarkMeshers(const VoxelWorld& world, const std::vector<ChunkCoord>& coords);
+
+// casts rayCount random rays of maxDist from origin through VoxelWorld::raycast, batched and one at a time
+RaycastBenchmark benchmarkRaycast(const VoxelWorld& world, glm::vec3 origin, float maxDist, size_t rayCount);
+
+// drops 1k/10k/100k entities over a square around center into stores of their own on scheduler,
+// ticks each and prints entities updated per millisecond
+EntityBenchmark benchmarkEntities(const VoxelWorld& world, TaskScheduler& scheduler, glm::vec3 center);
@@ -0,0 +1,218 @@
+#include "BlockStorage.h"
+#include <algorithm>
+
+BlockStorage::BlockStorage(size_t size, BlockID initial)
+    : m_size(size)
+{
+    m_palette.push_back(initial);
+    m_counts.push_back((uint32_t)size);
+}
+
+int BlockStorage::bitsFor(size_t paletteSize)
+{
+    if (paletteSize <= 1) return 0;
+    if (paletteSize <= 2) return 1;
+    if (paletteSize <= 4) return 2;
+    if (paletteSize <= 16) return 4;
+    return 8;
+}
+
+void BlockStorage::fill(BlockID type)
+{
+    m_bits = 0;
+    m_mask = 0;
+    m_palette.assign(1, type);
+    m_counts.assign(1, (uint32_t)m_size);
+    m_paletteLive = 1;
+    m_data.clear();
+    m_data.shrink_to_fit();
+}
+
+// fixed width so the shifts are constants and the inner loop unrolls
+template <int BITS>
+static void packWords(const BlockID* blocks, const uint8_t* slotOf, uint64_t* words, size_t wordCount)
+{
+    constexpr int PER_WORD = 64 / BITS;
+    for (size_t w = 0; w < wordCount; w++)
+    {
+        const BlockID* src = blocks + w * PER_WORD;
+        uint64_t packed = 0;
+        for (int k = 0; k < PER_WORD; k++)
+        {
+            packed |= (uint64_t)slotOf[src[k]] << (k * BITS);
+        }
+        words[w] = packed;
+    }
+}
+
+void BlockStorage::assign(const BlockID* blocks)
+{
+    // 1- count every type, palette in first seen order
+    uint32_t counts[256] = {};
+    for (size_t i = 0; i < m_size; i++) counts[blocks[i]]++;
+
+    size_t distinct = 0;
+    for (uint32_t count : counts) distinct += count > 0;
+
+    uint8_t slotOf[256] = {};
+    m_palette.clear();
+    m_counts.clear();
+    for (size_t i = 0; i < m_size && m_palette.size() < distinct; i++)
+    {
+        BlockID type = blocks[i];
+        if (counts[type] == 0) continue;
+
+        slotOf[type] = (uint8_t)m_palette.size();
+        m_palette.push_back(type);
+        m_counts.push_back(counts[type]);
+        counts[type] = 0; // seen
+    }
+    m_paletteLive = m_palette.size();
+
+    // 2- pack a word at a time
+    m_bits = bitsFor(m_palette.size());
+    m_mask = m_bits == 0 ? 0 : ((1ull << m_bits) - 1);
+    m_data.assign(m_bits == 0 ? 0 : (m_size * m_bits + 63) / 64, 0);
+
+    // whole words only, the chunk volume is always a multiple of 64 cells
+    size_t wordCount = m_bits == 0 ? 0 : m_size / (64 / m_bits);
+    switch (m_bits)
+    {
+        case 1: packWords<1>(blocks, slotOf, m_data.data(), wordCount); break;
+        case 2: packWords<2>(blocks, slotOf, m_data.data(), wordCount); break;
+        case 4: packWords<4>(blocks, slotOf, m_data.data(), wordCount); break;
+        case 8: packWords<8>(blocks, slotOf, m_data.data(), wordCount); break;
+        default: break;
+    }
+
+    // tail, only for sizes that arent a multiple of 64
+    for (size_t i = wordCount * (m_bits ? 64 / m_bits : 0); m_bits > 0 && i < m_size; i++)
+    {
+        setIndex(i, slotOf[blocks[i]]);
+    }
+}
+
+void BlockStorage::set(size_t index, BlockID type)
+{
+    uint32_t oldSlot = m_bits == 0 ? 0 : getIndex(index);
+    if (m_palette[oldSlot] == type) return;
+
+    // find the type, or a free slot for it
+    uint32_t slot = UINT32_MAX;
+    uint32_t freeSlot = UINT32_MAX;
+    for (uint32_t i = 0; i < m_palette.size(); i++)
+    {
+        if (m_counts[i] == 0)
+        {
+            if (freeSlot == UINT32_MAX) freeSlot = i;
+        }
+        else if (m_palette[i] == type)
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot == UINT32_MAX)
+    {
+        if (freeSlot != UINT32_MAX)
+        {
+            slot = freeSlot;
+            m_palette[slot] = type;
+        }
+        else
+        {
+            // every slot is in use, widen when the new one doesnt fit (no free slots = no renumbering)
+            if (bitsFor(m_palette.size() + 1) > m_bits) repack(bitsFor(m_palette.size() + 1));
+
+            slot = (uint32_t)m_palette.size();
+            m_palette.push_back(type);
+            m_counts.push_back(0);
+        }
+        m_paletteLive++;
+    }
+
+    oldSlot = getIndex(index);
+    setIndex(index, slot);
+    m_counts[slot]++;
+    m_counts[oldSlot]--;
+
+    if (m_counts[oldSlot] == 0)
+    {
+        m_paletteLive--;
+
+        // shrink once the live types fit in a narrower width
+        if (bitsFor(m_paletteLive) < m_bits) repack(bitsFor(m_paletteLive));
+    }
+}
+
+void BlockStorage::repack(int bits)
+{
+    // 1- compact palette, old slot -> new slot
+    std::vector<BlockID> palette;
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> remap(m_palette.size(), 0);
+    for (size_t i = 0; i < m_palette.size(); i++)
+    {
+        if (m_counts[i] == 0) continue;
+        remap[i] = (uint32_t)palette.size();
+        palette.push_back(m_palette[i]);
+        counts.push_back(m_counts[i]);
+    }
+
+    // 2- rewrite the indices at the new width
+    std::vector<uint64_t> data;
+    uint64_t mask = bits == 0 ? 0 : ((1ull << bits) - 1);
+    if (bits > 0)
+    {
+        data.assign((m_size * bits + 63) / 64, 0);
+        for (size_t i = 0; i < m_size; i++)
+        {
+            uint32_t oldSlot = m_bits == 0 ? 0 : getIndex(i);
+            size_t bit = i * bits;
+            data[bit >> 6] |= (uint64_t)remap[oldSlot] << (bit & 63);
+        }
+    }
+
+    m_bits = bits;
+    m_mask = mask;
+    m_palette = std::move(palette);
+    m_counts = std::move(counts);
+    m_paletteLive = m_palette.size();
+    m_data = std::move(data);
+}
+
+void BlockStorage::unpack(BlockID* out) const
+{
+    if (m_bits == 0)
+    {
+        std::fill(out, out + m_size, m_palette[0]);
+        return;
+    }
+
+    // walk whole words, every width divides 64 so no cell straddles two words
+    int perWord = 64 / m_bits;
+    size_t i = 0;
+    for (uint64_t word : m_data)
+    {
+        for (int k = 0; k < perWord && i < m_size; k++, i++)
+        {
+            out[i] = m_palette[word & m_mask];
+            word >>= m_bits;
+        }
+    }
+}
+
+bool BlockStorage::contains(BlockID type) const
+{
+    for (size_t i = 0; i < m_palette.size(); i++)
+    {
+        if (m_palette[i] == type && m_counts[i] > 0) return true;
+    }
+    return false;
+}
+
+size_t BlockStorage::getMemoryUsage() const
+{
+    return m_data.capacity() * sizeof(uint64_t) + m_palette.capacity() * sizeof(BlockID) + m_counts.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using BlockID = uint8_t;
+
+// palette compressed block array
+// each cell stores an index into a small per-chunk palette, packed at 0/1/2/4/8 bits
+// 0 bits = the whole chunk is one block (all air, all stone), nothing but the palette is stored
+// the index width grows when a new block type shows up and shrinks again once types disappear
+// chunks keep their packed light (a byte per cell) in one too
+class BlockStorage
+{
+public:
+    explicit BlockStorage(size_t size, BlockID initial = 0);
+
+    BlockID get(size_t index) const
+    {
+        if (m_bits == 0) return m_palette[0];
+
+        size_t bit = index * m_bits;
+        return m_palette[(m_data[bit >> 6] >> (bit & 63)) & m_mask];
+    }
+
+    void set(size_t index, BlockID type);
+
+    // back to a single value, drops the packed data
+    void fill(BlockID type);
+
+    // bulk replace from size() plain blocks, palette is built and packed in one go
+    void assign(const BlockID* blocks);
+
+    // writes size() blocks to out, faster than get() per cell
+    void unpack(BlockID* out) const;
+
+    bool isUniform() const { return m_bits == 0; }
+    // palette lookup, no cell is read
+    bool contains(BlockID type) const;
+    int getBitsPerBlock() const { return m_bits; }
+    size_t getPaletteSize() const { return m_paletteLive; }
+    size_t size() const { return m_size; }
+
+    // heap bytes held by this storage
+    size_t getMemoryUsage() const;
+
+private:
+    size_t m_size;
+    int m_bits = 0;
+    uint64_t m_mask = 0;
+
+    // palette slots with count 0 are free and get reused before the palette grows
+    std::vector<BlockID> m_palette;
+    std::vector<uint32_t> m_counts;
+    size_t m_paletteLive = 1;
+
+    std::vector<uint64_t> m_data;
+
+    uint32_t getIndex(size_t index) const
+    {
+        size_t bit = index * m_bits;
+        return (uint32_t)((m_data[bit >> 6] >> (bit & 63)) & m_mask);
+    }
+    void setIndex(size_t index, uint32_t value)
+    {
+        size_t bit = index * m_bits;
+        uint64_t& word = m_data[bit >> 6];
+        word = (word & ~(m_mask << (bit & 63))) | ((uint64_t)value << (bit & 63));
+    }
+
+    // smallest width in 0/1/2/4/8 that holds paletteSize entries
+    static int bitsFor(size_t paletteSize);
+
+    // rebuild at the given width, unused palette slots are dropped
+    void repack(int bits);
+};
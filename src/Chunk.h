@@ -1,13 +1,67 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
+#include "BlockStorage.h"
+#include "ChunkMeshArena.h"
+#include "ChunkVertex.h"
 
 constexpr int CHUNK_SIZE = 32;
 constexpr int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
 
-// type (0 = air, 1 = dirt)
-using BlockID = uint8_t;
+// bricks of BRICK_SIZE^3 blocks, a chunk counts the solid blocks in each so ray walks can skip empty ones
+constexpr int BRICK_SIZE = 4;
+constexpr int BRICK_SHIFT = 2;
+constexpr int BRICKS_PER_SIDE = CHUNK_SIZE / BRICK_SIZE;
+constexpr int BRICK_COUNT = BRICKS_PER_SIDE * BRICKS_PER_SIDE * BRICKS_PER_SIDE;
+
+// BlockID (0 = air, 1 = grass, 2 = dirt, 3 = stone, 4 = glowstone) comes from BlockStorage.h
+constexpr BlockID GLOWSTONE = 4;
+
+// per block light, sky light in the high 4 bits and block light (glowstone) in the low 4, 0..15 each
+// solid blocks are 0 except emitters, which hold their own emission as block light
+constexpr int MAX_LIGHT = 15;
+constexpr uint8_t FULL_SKY_LIGHT = MAX_LIGHT << 4;
+
+inline int getSkyLight(uint8_t light) { return light >> 4; }
+inline int getBlockLight(uint8_t light) { return light & 15; }
+
+// block light a block gives off
+inline int getBlockEmission(BlockID block) { return block == GLOWSTONE ? MAX_LIGHT : 0; }
+
+// naive = one quad per exposed face, greedy = coplanar same-texture faces merged per slice
+// binary = same quads as greedy, built from per row solid bitmasks instead of per block checks
+enum class MeshMode
+{
+    Naive,
+    Greedy,
+    Binary
+};
+
+inline const char* getMeshModeName(MeshMode mode)
+{
+    switch (mode)
+    {
+        case MeshMode::Naive: return "NAIVE";
+        case MeshMode::Greedy: return "GREEDY";
+        default: return "BINARY";
+    }
+}
+
+// which faces of a chunk can see each other through its air, bit a * 6 + b, symmetric
+// faces follow the CubeData order: 0=front (z+), 1=back (z-), 2=left (x-), 3=right (x+), 4=top (y+), 5=bottom (y-)
+using FaceConnectivity = uint64_t;
+constexpr FaceConnectivity ALL_FACES_CONNECTED = (1ull << 36) - 1;
+
+inline bool facesConnected(FaceConnectivity connectivity, int a, int b)
+{
+    return (connectivity >> (a * 6 + b)) & 1;
+}
+
+class PaddedBlocks;
 
 class Chunk
 {
@@ -16,35 +70,107 @@ public:
     ~Chunk();
 
     void setBlock(int x, int y, int z, BlockID type);
+    void fill(BlockID type);
+    // bulk replace from CHUNK_VOLUME blocks in getIndex order
+    void loadBlocks(const BlockID* blocks);
 
     BlockID getBlock(int x, int y, int z) const;
 
-    // mesh
-    void updateMesh();
-    void render();
+    // writes CHUNK_VOLUME blocks in getIndex order
+    void copyBlocks(BlockID* out) const { m_blocks.unpack(out); }
+
+    // copy this chunk into the middle of a padded block view (border is filled by VoxelWorld)
+    void copyInto(PaddedBlocks& padded) const;
+
+    // mesh, built off thread by buildChunkMesh and placed in the shared arena here (GL thread only)
+    // the previous mesh's space is rewritten in place when the new one fits
+    // lod = level the mesh was built at, its positions are in (1 << lod) block units
+    void uploadMesh(ChunkMeshArena& arena, const std::vector<PackedVertex>& vertices, const MeshBounds& bounds, int lod);
+
+    // gives the mesh space back to the arena now (GL thread), the chunk can then be destroyed on any thread
+    void releaseMesh();
+
+    size_t getVertexCount() const { return m_mesh.vertexCount; }
+    const ChunkMeshArena::Allocation& getMesh() const { return m_mesh; }
+    int getMeshLod() const { return m_meshLod; }
+    // chunk local box of the uploaded mesh, used for culling
+    const MeshBounds& getMeshBounds() const { return m_meshBounds; }
+
+    // from the last mesh build, everything connected until the first one lands
+    void setConnectivity(FaceConnectivity connectivity) { m_connectivity = connectivity; }
+    FaceConnectivity getConnectivity() const { return m_connectivity; }
+
+    // packed light per block, filled in by Lighting and VoxelWorld, all 0 (dark) for a new chunk
+    // bulk forms take CHUNK_VOLUME values in getIndex order, like loadBlocks / copyBlocks
+    void loadLight(const uint8_t* light) { m_light.assign(light); }
+    void copyLight(uint8_t* out) const { m_light.unpack(out); }
+    uint8_t getLight(int x, int y, int z) const { return m_light.get(getIndex(x, y, z)); }
+    void setLight(int x, int y, int z, uint8_t light) { m_light.set(getIndex(x, y, z), light); }
+    void fillLight(uint8_t light) { m_light.fill(light); }
+
+    bool containsBlock(BlockID type) const { return m_blocks.contains(type); }
+    // some column has air under its top block (a cave, an overhang), from the heightmap and layer counts
+    bool hasAirBelowSurface() const;
+
+    // highest solid local y of column x,z, -1 when the column is all air
+    int getHeight(int x, int z) const { return m_heights[x + z * CHUNK_SIZE]; }
+    // lowest / highest local y holding a solid block, min > max when the chunk is all air
+    int getMinY() const { return m_minY; }
+    int getMaxY() const { return m_maxY; }
+    bool isEmpty() const { return m_minY > m_maxY; }
+    // brick holding local x,y,z has no solid block
+    bool isBrickEmpty(int x, int y, int z) const { return m_brickCounts[getBrickIndex(x, y, z)] == 0; }
+
+    // all one block type, stored as a single palette entry
+    bool isUniform() const { return m_blocks.isUniform(); }
+    size_t getBlockMemoryUsage() const { return m_blocks.getMemoryUsage(); }
+    size_t getLightMemoryUsage() const { return m_light.getMemoryUsage(); }
+
+    // id of the latest mesh request for this chunk, results from older requests are dropped on upload
+    // ids come from one world wide counter, so a chunk unloaded and loaded again never matches its old requests
+    void setMeshRevision(uint64_t revision) { m_meshRevision = revision; }
+    uint64_t getMeshRevision() const { return m_meshRevision; }
+
+    // mesh snapshots still copying from this chunk on a worker, it isnt changed or destroyed until they are done
+    void addSnapshotReader() const { m_snapshotReaders++; }
+    void removeSnapshotReader() const { m_snapshotReaders--; }
+    bool hasSnapshotReaders() const { return m_snapshotReaders > 0; }
 
 private:
-    std::array<BlockID, CHUNK_VOLUME> m_blocks;
+    BlockStorage m_blocks;
+    // light values packed the same way as the blocks, a section takes only a handful of levels
+    // (full sky above the ground, dark under it, a few steps between), one value = nothing but the palette
+    BlockStorage m_light;
 
-    unsigned int m_VAO = 0; // vertex array obj
-    unsigned int m_VBO = 0; // vertex buffer obj
-    size_t m_vertex_count = 0;
+    // kept up to date by every write: top solid block per column and solid block count per layer
+    std::array<int8_t, CHUNK_SIZE * CHUNK_SIZE> m_heights;
+    std::array<uint16_t, CHUNK_SIZE> m_layerCounts;
+    // solid blocks per brick, up to BRICK_SIZE^3
+    std::array<uint8_t, BRICK_COUNT> m_brickCounts;
+    int m_minY = CHUNK_SIZE;
+    int m_maxY = -1;
 
-    // convert x,y,z to index = x + (z * size) + (y * size * size)
-    inline int getIndex(int x, int y, int z) const
+    // arena the mesh was uploaded to, its space is released with the chunk
+    ChunkMeshArena* m_arena = nullptr;
+    ChunkMeshArena::Allocation m_mesh;
+    MeshBounds m_meshBounds;
+    int m_meshLod = 0;
+    FaceConnectivity m_connectivity = ALL_FACES_CONNECTED;
+    uint64_t m_meshRevision = 0;
+    mutable std::atomic<int> m_snapshotReaders{0};
+
+    // min/max y from the layer counts
+    void updateOccupiedRange();
+
+    // brick of local x,y,z, index = bx + (bz * bricks) + (by * bricks * bricks) like getIndex
+    static int getBrickIndex(int x, int y, int z)
     {
-        return x + (z * CHUNK_SIZE) + (y * CHUNK_SIZE * CHUNK_SIZE);
+        return (x >> BRICK_SHIFT) + ((z >> BRICK_SHIFT) * BRICKS_PER_SIDE) + ((y >> BRICK_SHIFT) * BRICKS_PER_SIDE * BRICKS_PER_SIDE);
     }
 
-    bool isSolid(int x, int y, int z) const
+    // convert x,y,z to index = x + (z * size) + (y * size * size)
+    inline int getIndex(int x, int y, int z) const
     {
-        if (x < 0 || x >= CHUNK_SIZE ||
-            y < 0 || y >= CHUNK_SIZE ||
-            z < 0 || z >= CHUNK_SIZE)
-        {
-            return false; 
-        }
-
-        return m_blocks[getIndex(x, y, z)] > 0;
+        return x + (z * CHUNK_SIZE) + (y * CHUNK_SIZE * CHUNK_SIZE);
     }
 };
\ No newline at end of file
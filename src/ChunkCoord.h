@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Chunk.h"
+
+// section address in chunk units, world block x = coord.x * CHUNK_SIZE + local x (same for y, z)
+struct ChunkCoord
+{
+    int x;
+    int y;
+    int z;
+
+    bool operator==(const ChunkCoord& other) const = default;
+};
+
+// vertical stack of sections, generated and streamed as one unit
+struct ColumnCoord
+{
+    int x;
+    int z;
+
+    bool operator==(const ColumnCoord& other) const = default;
+};
+
+// pack into 64 bits and mix, neighbouring coords land in different buckets
+inline size_t mixChunkKey(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key;
+}
+
+struct ChunkCoordHash
+{
+    size_t operator()(const ChunkCoord& c) const
+    {
+        // 24 bits for x/z, 16 for y
+        uint64_t key = ((uint64_t)((uint32_t)c.x & 0xFFFFFF) << 40) |
+                       ((uint64_t)((uint32_t)c.z & 0xFFFFFF) << 16) |
+                       ((uint32_t)c.y & 0xFFFF);
+        return mixChunkKey(key);
+    }
+};
+
+struct ColumnCoordHash
+{
+    size_t operator()(const ColumnCoord& c) const
+    {
+        return mixChunkKey(((uint64_t)(uint32_t)c.x << 32) | (uint32_t)c.z);
+    }
+};
+
+// division and modulo that round towards -inf, so -1 is in chunk -1 at local 31
+inline int floorDiv(int value, int size)
+{
+    return (value >= 0) ? value / size : ((value + 1) / size) - 1;
+}
+
+inline int floorMod(int value, int size)
+{
+    int m = value % size;
+    return (m < 0) ? m + size : m;
+}
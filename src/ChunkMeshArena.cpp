@@ -0,0 +1,204 @@
+#include "ChunkMeshArena.h"
+#include "QuadIndexBuffer.h"
+#include <glad/glad.h>
+#include <cstddef>
+
+// 1M vertices (8 MiB) to start, the default load radius with lod fits in it
+static const size_t INITIAL_CAPACITY = 1 << 20;
+// allocations are rounded to this many vertices, stops tiny leftover holes from piling up
+static const size_t ALLOCATION_GRANULARITY = 64;
+// a few frames of upload budget, a frame normally never waits on a fence
+static const size_t STAGING_CAPACITY = 8 * 1024 * 1024;
+
+ChunkMeshArena::ChunkMeshArena()
+    : m_staging(STAGING_CAPACITY)
+{
+}
+
+ChunkMeshArena::~ChunkMeshArena()
+{
+    if (m_VAO != 0) glDeleteVertexArrays(1, &m_VAO);
+    if (m_VBO != 0) glDeleteBuffers(1, &m_VBO);
+    if (m_originBuffer != 0) glDeleteBuffers(1, &m_originBuffer);
+    if (m_indirectBuffer != 0) glDeleteBuffers(1, &m_indirectBuffer);
+}
+
+void ChunkMeshArena::init()
+{
+#ifndef VOXEL_HEADLESS
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_originBuffer);
+    glGenBuffers(1, &m_indirectBuffer);
+
+    glBindVertexArray(m_VAO);
+
+    // ATTRIB 1: CHUNK ORIGIN + SCALE (vec4), one per draw, the draw's baseInstance picks it
+    glBindBuffer(GL_ARRAY_BUFFER, m_originBuffer);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(1);
+
+    // shared index buffer, recorded in this VAO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, QuadIndexBuffer::get(0));
+
+    glBindVertexArray(0);
+#endif
+
+    grow(INITIAL_CAPACITY);
+}
+
+void ChunkMeshArena::grow(size_t newCapacity)
+{
+#ifndef VOXEL_HEADLESS
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    // immutable storage, only ever written by GPU copies (sub data is kept for the oversized fallback)
+    glBufferStorage(GL_COPY_WRITE_BUFFER, newCapacity * sizeof(PackedVertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    // gpu side copy, meshes keep their offsets so nothing outside has to change
+    if (m_VBO != 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_VBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_allocator.getCapacity() * sizeof(PackedVertex));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &m_VBO);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    m_VBO = buffer;
+
+    // ATTRIB 0: PACKED VERTEX (1 uint), integer attrib so the bits survive
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)offsetof(PackedVertex, data));
+    glEnableVertexAttribArray(0);
+    // ATTRIB 2: PACKED LIGHT (1 uint)
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)offsetof(PackedVertex, light));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+#endif
+
+    m_allocator.grow(newCapacity);
+}
+
+void ChunkMeshArena::write([[maybe_unused]] size_t offset, const std::vector<PackedVertex>& vertices)
+{
+    size_t bytes = vertices.size() * sizeof(PackedVertex);
+#ifndef VOXEL_HEADLESS
+    size_t staged = m_staging.write(vertices.data(), bytes);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_VBO);
+    if (staged != StagingRing::INVALID)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_staging.getBuffer());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, staged, offset * sizeof(PackedVertex), bytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    else
+    {
+        // bigger than half the ring, only a pathological mesh gets here
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset * sizeof(PackedVertex), bytes, vertices.data());
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+#endif
+
+    m_uploadedBytes += bytes;
+}
+
+void ChunkMeshArena::update(Allocation& allocation, const std::vector<PackedVertex>& vertices)
+{
+    if (vertices.empty())
+    {
+        release(allocation);
+        allocation = Allocation();
+        return;
+    }
+    if (m_allocator.getCapacity() == 0) init();
+
+    size_t reserved = (vertices.size() + ALLOCATION_GRANULARITY - 1) / ALLOCATION_GRANULARITY * ALLOCATION_GRANULARITY;
+
+    // same space again if it fits and isnt mostly wasted, the usual case for a block edit
+    if (reserved <= allocation.reserved && allocation.reserved <= reserved * 2)
+    {
+        write(allocation.offset, vertices);
+        allocation.vertexCount = vertices.size();
+        m_inPlaceUpdates++;
+        return;
+    }
+
+    release(allocation);
+
+    size_t offset = m_allocator.allocate(reserved);
+    if (offset == FreeListAllocator::INVALID)
+    {
+        size_t capacity = m_allocator.getCapacity() * 2;
+        while (capacity - m_allocator.getUsed() < reserved * 2) capacity *= 2;
+        grow(capacity);
+        offset = m_allocator.allocate(reserved);
+    }
+
+    write(offset, vertices);
+
+    // the index buffer keeps its name when it grows, so the VAO binding stays valid
+    if (vertices.size() > m_largestMesh)
+    {
+        m_largestMesh = vertices.size();
+#ifndef VOXEL_HEADLESS
+        QuadIndexBuffer::get(m_largestMesh / 4);
+#endif
+    }
+
+    allocation.offset = offset;
+    allocation.vertexCount = vertices.size();
+    allocation.reserved = reserved;
+}
+
+void ChunkMeshArena::finishUploads()
+{
+#ifndef VOXEL_HEADLESS
+    m_staging.fence();
+#endif
+}
+
+void ChunkMeshArena::release(const Allocation& allocation)
+{
+    if (allocation.reserved == 0) return;
+    m_allocator.free(allocation.offset, allocation.reserved);
+}
+
+void ChunkMeshArena::addDraw(const Allocation& allocation, glm::vec3 origin, float scale)
+{
+    if (allocation.vertexCount == 0) return;
+
+    DrawCommand command;
+    command.count = (uint32_t)(allocation.vertexCount / 4 * 6); // 4 vertices and 6 indices per quad
+    command.instanceCount = 1;
+    command.firstIndex = 0;
+    command.baseVertex = (int32_t)allocation.offset;
+    command.baseInstance = (uint32_t)m_origins.size();
+    m_commands.push_back(command);
+    m_origins.push_back(glm::vec4(origin, scale));
+}
+
+void ChunkMeshArena::drawAll()
+{
+    if (m_commands.empty()) return;
+
+#ifndef VOXEL_HEADLESS
+    // both buffers are rewritten every frame, orphan them so the driver doesnt wait on last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, m_originBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_origins.size() * sizeof(glm::vec4), m_origins.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_commands.size() * sizeof(DrawCommand), m_commands.data(), GL_STREAM_DRAW);
+
+    glBindVertexArray(m_VAO);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, (GLsizei)m_commands.size(), 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+#endif
+
+    m_commands.clear();
+    m_origins.clear();
+}
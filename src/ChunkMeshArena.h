@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "ChunkVertex.h"
+#include "FreeListAllocator.h"
+#include "StagingRing.h"
+
+// every chunk mesh lives in one shared vertex buffer, placed by a FreeListAllocator
+// one VAO for all of them, a frame is a single glMultiDrawElementsIndirect over the queued draws
+// chunk origin and lod scale are a per draw attribute (divisor 1) picked by each command's baseInstance
+// uploads go through a persistently mapped StagingRing and a GPU side copy, no buffer is ever respecified
+// GL thread only, GL objects are created on first use
+// built with VOXEL_HEADLESS (the bench) it never touches GL: meshes are still placed and counted, queued draws are dropped
+class ChunkMeshArena
+{
+public:
+    // where a mesh sits in the buffer, in vertices
+    struct Allocation
+    {
+        size_t offset = 0;
+        size_t vertexCount = 0;
+        size_t reserved = 0; // rounded up size actually taken from the allocator
+    };
+
+    ChunkMeshArena();
+    ~ChunkMeshArena();
+
+    ChunkMeshArena(const ChunkMeshArena&) = delete;
+    ChunkMeshArena& operator=(const ChunkMeshArena&) = delete;
+
+    // replaces the mesh in allocation with vertices (allocation can be empty for a new mesh)
+    // rewritten in place when it still fits, otherwise moved, the buffer grows (keeping every offset) if nothing fits
+    void update(Allocation& allocation, const std::vector<PackedVertex>& vertices);
+    void release(const Allocation& allocation);
+
+    // fences this batch of uploads in the staging ring, once per frame after the last update
+    void finishUploads();
+
+    // queue one chunk for this frame, origin = world position of its (0,0,0) corner
+    // scale = blocks per mesh unit, 1 << lod
+    void addDraw(const Allocation& allocation, glm::vec3 origin, float scale);
+    // submits everything queued in one call and clears the queue
+    void drawAll();
+
+    size_t getCapacityVertices() const { return m_allocator.getCapacity(); }
+    size_t getUsedVertices() const { return m_allocator.getUsed(); }
+    size_t getFreeBlockCount() const { return m_allocator.getFreeBlockCount(); }
+
+    // totals since startup
+    size_t getUploadedBytes() const { return m_uploadedBytes; }
+    size_t getFenceWaits() const { return m_staging.getFenceWaits(); }
+    size_t getInPlaceUpdates() const { return m_inPlaceUpdates; }
+
+private:
+    // matches the GL DrawElementsIndirectCommand layout
+    struct DrawCommand
+    {
+        uint32_t count;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t baseInstance;
+    };
+
+    FreeListAllocator m_allocator;
+    StagingRing m_staging;
+
+    unsigned int m_VAO = 0;
+    unsigned int m_VBO = 0;
+    unsigned int m_originBuffer = 0;
+    unsigned int m_indirectBuffer = 0;
+    size_t m_largestMesh = 0; // in vertices, the shared index buffer has to cover it
+
+    std::vector<DrawCommand> m_commands;
+    std::vector<glm::vec4> m_origins; // (origin, scale)
+
+    size_t m_uploadedBytes = 0;
+    size_t m_inPlaceUpdates = 0;
+
+    void init();
+    // new buffer of newCapacity vertices, old contents copied over at the same offsets
+    void grow(size_t newCapacity);
+    // staging copy of vertices to offset (in vertices)
+    void write(size_t offset, const std::vector<PackedVertex>& vertices);
+};
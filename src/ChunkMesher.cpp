@@ -0,0 +1,670 @@
+#include "ChunkMesher.h"
+#include <bit>
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#include "CubeData.h" // vertex data
+
+const int ATLAS_ROWS = 16;
+const int ATLAS_COLS = 16;
+
+static void getTextureIndex(BlockID blockID, int face_index, int &row, int &col)
+{
+    // face index map: 0=front, 1=back, 2=left, 3=right, 4=top, 5=bottom
+    switch (blockID)
+    {
+        case 1: // grass
+            if (face_index == 4) { row = 12; col = 12; }  // top
+            else if (face_index == 5) { row = 0; col = 2; }  // bottom
+            else { row = 0; col = 3; }  // sides
+            break;
+        case 2: // dirt
+            row = 0; col = 2;
+            break;
+        case 3: // stone
+            row = 0; col = 1;
+            break;
+        case 4: // glowstone
+            row = 6; col = 9;
+            break;
+        default: // error texture
+            row = 9; col = 9;
+            break;
+    }
+}
+
+// atlas tile (png row * ATLAS_COLS + png col) of every block id and face
+// the meshers look a face up here instead of going through the switch for every face
+static const auto faceTiles = []
+{
+    std::array<std::array<uint8_t, 6>, 256> table{};
+    for (int block = 0; block < 256; block++)
+    {
+        for (int f = 0; f < 6; f++)
+        {
+            int pngRow, pngCol;
+            getTextureIndex((BlockID)block, f, pngRow, pngCol);
+            table[block][f] = (uint8_t)(pngRow * ATLAS_COLS + pngCol);
+        }
+    }
+    return table;
+}();
+
+// axis the face normal points along, and the two in-plane axes the greedy merge grows along
+static const int faceNormalAxis[6] = { 2, 2, 0, 0, 1, 1 };
+static const int faceUAxis[6] = { 0, 0, 2, 2, 0, 0 };
+static const int faceVAxis[6] = { 1, 1, 1, 1, 2, 2 };
+
+// ambient occlusion of a face corner comes from the 2 side blocks and the diagonal block touching it,
+// all in the layer in front of the face, stored as steps from the front cell's padded index
+// the front cell is at most 1 outside the chunk and the steps stay in its face plane, so it never leaves the border
+struct CornerOcclusion
+{
+    int side1;
+    int side2;
+    int corner;
+};
+
+static const auto cornerOcclusion = []
+{
+    std::array<std::array<CornerOcclusion, 4>, 6> table{};
+    for (int f = 0; f < 6; f++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            int du[3] = { 0, 0, 0 };
+            int dv[3] = { 0, 0, 0 };
+            du[faceUAxis[f]] = cubeFaceCorners[f][c][faceUAxis[f]] ? 1 : -1;
+            dv[faceVAxis[f]] = cubeFaceCorners[f][c][faceVAxis[f]] ? 1 : -1;
+
+            int side1 = PaddedBlocks::getIndex(du[0], du[1], du[2]) - PaddedBlocks::getIndex(0, 0, 0);
+            int side2 = PaddedBlocks::getIndex(dv[0], dv[1], dv[2]) - PaddedBlocks::getIndex(0, 0, 0);
+            table[f][c] = { side1, side2, side1 + side2 };
+        }
+    }
+    return table;
+}();
+
+// every corner open, what faces get with ambient occlusion off
+static const uint8_t NO_OCCLUSION = 0xFF;
+
+// 2 bits per corner: 3 = open, one less per solid neighbour, 0 when both sides are solid (the corner block cant be seen)
+static uint8_t faceOcclusion(const BlockID* blocks, int front, int face)
+{
+    uint8_t packed = 0;
+    for (int c = 0; c < 4; c++)
+    {
+        const CornerOcclusion& o = cornerOcclusion[face][c];
+        int side1 = blocks[front + o.side1] != 0;
+        int side2 = blocks[front + o.side2] != 0;
+        int corner = blocks[front + o.corner] != 0;
+        int level = (side1 && side2) ? 0 : 3 - (side1 + side2 + corner);
+        packed |= (uint8_t)(level << (c * 2));
+    }
+    return packed;
+}
+
+// writes one quad (4 vertices) covering size[] blocks starting at block pos[]
+// pngTile is the face's atlas tile from faceTiles
+// texture coords arent stored, the shader derives them from the position so tiles repeat across merged quads
+// light is the packed light of the blocks in front of the face, the same for the whole quad
+// ao holds the 4 corner occlusion levels (see faceOcclusion)
+static void emitQuad(std::vector<PackedVertex>& vertices, int face, const int pos[3], const int size[3], int pngTile, uint8_t light, uint8_t ao)
+{
+    // opengl wants us to flip
+    int glRow = (ATLAS_ROWS - 1) - pngTile / ATLAS_COLS;
+    int tile = glRow * ATLAS_COLS + pngTile % ATLAS_COLS;
+
+    // quads are drawn as 0,1,2 + 2,3,0, so splitting along 0-2 spreads one dark corner over both triangles
+    // starting at corner 1 puts the split on 1-3 instead, whichever diagonal is darker gets it
+    int occlusion[4] = { ao & 3, (ao >> 2) & 3, (ao >> 4) & 3, (ao >> 6) & 3 };
+    int first = occlusion[0] + occlusion[2] < occlusion[1] + occlusion[3] ? 1 : 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        int corner = (first + i) & 3;
+        const int* c = cubeFaceCorners[face][corner];
+
+        vertices.push_back(packVertex(pos[0] + c[0] * size[0],
+                                      pos[1] + c[1] * size[1],
+                                      pos[2] + c[2] * size[2],
+                                      face, corner, tile, getSkyLight(light), getBlockLight(light), occlusion[corner]));
+    }
+}
+
+static void buildNaiveMesh(const PaddedBlocks& blocks, bool ambientOcclusion, std::vector<PackedVertex>& vertices)
+{
+    const int unit[3] = { 1, 1, 1 };
+    const int size = blocks.getSize();
+    const BlockID* data = blocks.getBlockData();
+
+    // loop every block in the chunk, layers with nothing solid are skipped
+    for (int y = blocks.getMinY(); y <= blocks.getMaxY(); y++) 
+    {
+        for (int z = 0; z < size; z++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                BlockID block = blocks.get(x, y, z);
+
+                if (block > 0)  // if block is not air
+                {
+                    // faces
+                    for (int f = 0; f < 6; f++)
+                    {
+                        // neighbor check
+                        int nx = x + cubeFaceNormals[f][0];
+                        int ny = y + cubeFaceNormals[f][1];
+                        int nz = z + cubeFaceNormals[f][2];
+
+                        // culling, drawing faces if neigbour is empty/air
+                        if (!blocks.isSolid(nx, ny, nz))
+                        {
+                            const int pos[3] = { x, y, z };
+                            uint8_t ao = ambientOcclusion ? faceOcclusion(data, PaddedBlocks::getIndex(nx, ny, nz), f) : NO_OCCLUSION;
+                            emitQuad(vertices, f, pos, unit, faceTiles[block][f], blocks.getLight(nx, ny, nz), ao);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void buildGreedyMesh(const PaddedBlocks& blocks, bool ambientOcclusion, std::vector<PackedVertex>& vertices)
+{
+    // per slice key of every visible face, ao << 16 | light << 8 | texture tile, one compare tells whether two faces merge
+    // faces[j] has a bit per visible face of row j, so the merge jumps between faces instead of walking empty cells
+    std::array<uint32_t, CHUNK_SIZE * CHUNK_SIZE> keys;
+    std::array<uint32_t, CHUNK_SIZE> faces;
+    const int size = blocks.getSize();
+    const BlockID* data = blocks.getBlockData();
+    const uint8_t* light = blocks.getLightData();
+
+    // padded index steps along x, y, z
+    const int origin = PaddedBlocks::getIndex(0, 0, 0);
+    const int steps[3] = { 1, PADDED_SIZE * PADDED_SIZE, PADDED_SIZE };
+
+    for (int f = 0; f < 6; f++)
+    {
+        int n = faceNormalAxis[f];
+        int u = faceUAxis[f];
+        int v = faceVAxis[f];
+        const int* normal = cubeFaceNormals[f];
+        const int frontStep = PaddedBlocks::getIndex(normal[0], normal[1], normal[2]) - origin;
+
+        // only the occupied layers can have faces: top/bottom slices are layers, side slices have them as rows
+        int firstSlice = n == 1 ? blocks.getMinY() : 0;
+        int lastSlice = n == 1 ? blocks.getMaxY() : size - 1;
+        int firstRow = v == 1 ? blocks.getMinY() : 0;
+        int lastRow = v == 1 ? blocks.getMaxY() : size - 1;
+
+        for (int slice = firstSlice; slice <= lastSlice; slice++)
+        {
+            // 1- collect the exposed faces of this slice, walking the padded arrays by index
+            for (int j = firstRow; j <= lastRow; j++)
+            {
+                int index = origin + slice * steps[n] + j * steps[v];
+                uint32_t* row = &keys[j * CHUNK_SIZE];
+                uint32_t bits = 0;
+                for (int i = 0; i < size; i++, index += steps[u])
+                {
+                    BlockID block = data[index];
+                    int front = index + frontStep;
+                    if (block == 0 || data[front] != 0) continue;
+
+                    uint32_t ao = ambientOcclusion ? faceOcclusion(data, front, f) : NO_OCCLUSION;
+                    row[i] = (ao << 16) | ((uint32_t)light[front] << 8) | faceTiles[block][f];
+                    bits |= 1u << i;
+                }
+                faces[j] = bits;
+            }
+
+            // 2- grow rectangles, first along u then along v
+            for (int j = firstRow; j <= lastRow; j++)
+            {
+                const uint32_t* row = &keys[j * CHUNK_SIZE];
+                while (faces[j])
+                {
+                    int i = std::countr_zero(faces[j]);
+                    uint32_t key = row[i];
+
+                    int width = 1;
+                    while (i + width < size && (faces[j] >> (i + width) & 1) && row[i + width] == key) width++;
+                    uint32_t run = (width == 32 ? 0xFFFFFFFFu : (1u << width) - 1) << i;
+
+                    int height = 1;
+                    while (j + height <= lastRow && (faces[j + height] & run) == run)
+                    {
+                        const uint32_t* next = &keys[(j + height) * CHUNK_SIZE];
+                        int k = 0;
+                        while (k < width && next[i + k] == key) k++;
+                        if (k < width) break;
+
+                        // consume the merged faces
+                        faces[j + height] &= ~run;
+                        height++;
+                    }
+                    faces[j] &= ~run;
+
+                    int pos[3];
+                    pos[n] = slice;
+                    pos[u] = i;
+                    pos[v] = j;
+
+                    int extent[3];
+                    extent[n] = 1;
+                    extent[u] = width;
+                    extent[v] = height;
+
+                    emitQuad(vertices, f, pos, extent, key & 0xFF, (uint8_t)(key >> 8), (uint8_t)(key >> 16));
+                }
+            }
+        }
+    }
+}
+
+// solid bit per block of a padded row (PADDED_SIZE blocks), bit 0 = the border block at x = -1
+// one byte compare per lane instead of a branch per block, the scalar loop is the fallback off x86
+static uint64_t solidRowMask(const BlockID* row)
+{
+#if defined(__AVX2__)
+    __m256i air = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)row), _mm256_setzero_si256());
+    uint64_t mask = (uint32_t)~_mm256_movemask_epi8(air);
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128i zero = _mm_setzero_si128();
+    uint32_t low = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)row), zero));
+    uint32_t high = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(row + 16)), zero));
+    uint64_t mask = (uint32_t)~(low | (high << 16));
+#else
+    uint64_t mask = 0;
+    for (int i = 0; i < 32; i++) mask |= (uint64_t)(row[i] != 0) << i;
+#endif
+    mask |= (uint64_t)(row[32] != 0) << 32;
+    mask |= (uint64_t)(row[33] != 0) << 33;
+    return mask;
+}
+
+// binary greedy meshing: solidity is one bitmask per x row, so a whole row of exposed faces is
+// a shift and an and-not against the row itself (x faces) or the neighbouring row (y, z faces)
+// exposed faces are sorted into per texture and light bit planes, and rectangles are grown on those planes
+// with bit scans, same quads as buildGreedyMesh
+static void buildBinaryMesh(const PaddedBlocks& blocks, bool ambientOcclusion, std::vector<PackedVertex>& vertices)
+{
+    const int size = blocks.getSize();
+    const uint32_t sizeMask = size == 32 ? 0xFFFFFFFFu : (1u << size) - 1;
+    const BlockID* data = blocks.getBlockData();
+    const int minY = blocks.getMinY();
+    const int maxY = blocks.getMaxY();
+    if (minY > maxY) return;
+
+    // rows of the occupied layers and the one above and below them, nothing else is read
+    std::array<uint64_t, PADDED_SIZE * PADDED_SIZE> rows;
+    auto rowIndex = [](int y, int z) { return (y + 1) * PADDED_SIZE + (z + 1); };
+    for (int y = minY - 1; y <= maxY + 1; y++)
+    {
+        for (int z = -1; z <= size; z++) rows[rowIndex(y, z)] = solidRowMask(blocks.getPaddedRow(y, z));
+    }
+
+    // exposed faces of one row in local x bits, a solid block with air on the face's side
+    auto exposedFaces = [&](int f, int y, int z) -> uint32_t
+    {
+        uint64_t row = rows[rowIndex(y, z)];
+        uint64_t faces;
+        switch (f)
+        {
+            case 0: faces = row & ~rows[rowIndex(y, z + 1)]; break;
+            case 1: faces = row & ~rows[rowIndex(y, z - 1)]; break;
+            case 2: faces = row & ~(row << 1); break;
+            case 3: faces = row & ~(row >> 1); break;
+            case 4: faces = row & ~rows[rowIndex(y + 1, z)]; break;
+            default: faces = row & ~rows[rowIndex(y - 1, z)]; break;
+        }
+        return (uint32_t)(faces >> 1) & sizeMask;
+    };
+
+    // one plane set per (texture tile, light) of the current face, plane[slice * CHUNK_SIZE + v] = bits along u
+    // planeKey is light << 8 | tile
+    // planeSlices has a bit per slice with faces in it
+    // a face of a chunk only sees a handful of keys, so they are found by a linear search
+    // openPlanes marks the faces with no corner occluded, most of them, those merge with plain bit ops
+    // the rest keep their corner levels in faceAO (slice, v, u) and only merge with identical ones
+    // all of it is scratch kept per thread, a worker meshes chunk after chunk without allocating
+    // planes are cleared as they are taken, faceAO is only read where the same face wrote it
+    static thread_local std::vector<std::array<uint32_t, CHUNK_SIZE * CHUNK_SIZE>> planes;
+    static thread_local std::vector<std::array<uint32_t, CHUNK_SIZE * CHUNK_SIZE>> openPlanes;
+    static thread_local std::vector<uint32_t> planeKey;
+    static thread_local std::vector<uint32_t> planeSlices;
+    static thread_local std::vector<uint8_t> faceAO(CHUNK_VOLUME);
+
+    for (int f = 0; f < 6; f++)
+    {
+        int n = faceNormalAxis[f];
+        int u = faceUAxis[f];
+        int v = faceVAxis[f];
+        const int* normal = cubeFaceNormals[f];
+        const int frontStep = PaddedBlocks::getIndex(normal[0], normal[1], normal[2]) - PaddedBlocks::getIndex(0, 0, 0);
+
+        // 1- sort the exposed faces by texture and light
+        size_t used = 0;
+        uint32_t lastKey = 0xFFFFFFFFu;
+        size_t lastSlot = 0;
+        for (int y = minY; y <= maxY; y++)
+        {
+            for (int z = 0; z < size; z++)
+            {
+                uint32_t faces = exposedFaces(f, y, z);
+                while (faces)
+                {
+                    int x = std::countr_zero(faces);
+                    faces &= faces - 1;
+
+                    BlockID block = blocks.get(x, y, z);
+                    uint32_t light = blocks.getLight(x + normal[0], y + normal[1], z + normal[2]);
+                    uint32_t key = (light << 8) | faceTiles[block][f];
+                    if (key != lastKey)
+                    {
+                        size_t slot = 0;
+                        while (slot < used && planeKey[slot] != key) slot++;
+                        if (slot == used)
+                        {
+                            if (used == planes.size())
+                            {
+                                planes.emplace_back();
+                                openPlanes.emplace_back();
+                                planeKey.push_back(0);
+                                planeSlices.push_back(0);
+                            }
+                            planes[used].fill(0);
+                            openPlanes[used].fill(0);
+                            planeKey[used] = key;
+                            planeSlices[used] = 0;
+                            used++;
+                        }
+                        lastKey = key;
+                        lastSlot = slot;
+                    }
+
+                    const int p[3] = { x, y, z };
+                    int row = p[n] * CHUNK_SIZE + p[v];
+                    uint8_t ao = ambientOcclusion ? faceOcclusion(data, PaddedBlocks::getIndex(x, y, z) + frontStep, f) : NO_OCCLUSION;
+                    planes[lastSlot][row] |= 1u << p[u];
+                    if (ao == NO_OCCLUSION) openPlanes[lastSlot][row] |= 1u << p[u];
+                    else faceAO[row * CHUNK_SIZE + p[u]] = ao;
+                    planeSlices[lastSlot] |= 1u << p[n];
+                }
+            }
+        }
+
+        // 2- grow rectangles, a run of set bits along u then down the rows along v while they hold the whole run
+        for (size_t slot = 0; slot < used; slot++)
+        {
+            for (uint32_t slices = planeSlices[slot]; slices; slices &= slices - 1)
+            {
+                int slice = std::countr_zero(slices);
+                uint32_t* plane = &planes[slot][slice * CHUNK_SIZE];
+                uint32_t* open = &openPlanes[slot][slice * CHUNK_SIZE];
+                const uint8_t* sliceAO = &faceAO[slice * CHUNK_SIZE * CHUNK_SIZE];
+                for (int j = 0; j < size; j++)
+                {
+                    while (plane[j])
+                    {
+                        int i = std::countr_zero(plane[j]);
+                        uint8_t ao;
+                        int width;
+                        int height = 1;
+                        uint32_t run;
+                        if (open[j] & (1u << i))
+                        {
+                            // open faces, whole runs at once
+                            ao = NO_OCCLUSION;
+                            width = std::countr_one(open[j] >> i);
+                            run = (width == 32 ? 0xFFFFFFFFu : (1u << width) - 1) << i;
+                            while (j + height < size && (open[j + height] & run) == run)
+                            {
+                                plane[j + height] &= ~run;
+                                open[j + height] &= ~run;
+                                height++;
+                            }
+                        }
+                        else
+                        {
+                            // occluded faces, a cell at a time against the first one's corners
+                            ao = sliceAO[j * CHUNK_SIZE + i];
+                            auto matches = [&](int row, int cell)
+                            {
+                                return ((plane[row] & ~open[row]) >> cell & 1) && sliceAO[row * CHUNK_SIZE + cell] == ao;
+                            };
+                            width = 1;
+                            while (i + width < size && matches(j, i + width)) width++;
+                            run = (width == 32 ? 0xFFFFFFFFu : (1u << width) - 1) << i;
+                            while (j + height < size)
+                            {
+                                int k = 0;
+                                while (k < width && matches(j + height, i + k)) k++;
+                                if (k < width) break;
+                                plane[j + height] &= ~run;
+                                height++;
+                            }
+                        }
+                        plane[j] &= ~run;
+                        open[j] &= ~run;
+
+                        int pos[3];
+                        pos[n] = slice;
+                        pos[u] = i;
+                        pos[v] = j;
+
+                        int extent[3];
+                        extent[n] = 1;
+                        extent[u] = width;
+                        extent[v] = height;
+
+                        emitQuad(vertices, f, pos, extent, planeKey[slot] & 0xFF, (uint8_t)(planeKey[slot] >> 8), ao);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void buildChunkMesh(const PaddedBlocks& blocks, MeshMode mode, bool ambientOcclusion, std::vector<PackedVertex>& vertices)
+{
+    switch (mode)
+    {
+        case MeshMode::Naive: buildNaiveMesh(blocks, ambientOcclusion, vertices); break;
+        case MeshMode::Greedy: buildGreedyMesh(blocks, ambientOcclusion, vertices); break;
+        default: buildBinaryMesh(blocks, ambientOcclusion, vertices); break;
+    }
+}
+
+void downsampleBlocks(const PaddedBlocks& source, int lod, int skirtFaces, PaddedBlocks& out)
+{
+    const int scale = 1 << lod;
+    const int size = CHUNK_SIZE / scale;
+    out.setSize(size);
+
+    // cells holding any of the occupied source layers, empty source = min > max here too
+    int minY = source.getMinY() >> lod;
+    int maxY = source.getMaxY() >> lod;
+    out.setOccupiedY(minY, maxY);
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int z = 0; z < size; z++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                int solid = 0;
+                int topY = -1;
+                BlockID top = 0;
+                for (int dy = 0; dy < scale; dy++)
+                {
+                    for (int dz = 0; dz < scale; dz++)
+                    {
+                        for (int dx = 0; dx < scale; dx++)
+                        {
+                            BlockID block = source.get(x * scale + dx, y * scale + dy, z * scale + dz);
+                            if (block == 0) continue;
+                            solid++;
+                            if (dy > topY) { topY = dy; top = block; }
+                        }
+                    }
+                }
+                if (solid * 2 >= scale * scale * scale) out.set(x, y, z, top);
+            }
+        }
+    }
+
+    // border layers, from the 1 block thick source border
+    for (int f = 0; f < 6; f++)
+    {
+        if (skirtFaces & (1 << f)) continue;
+
+        int n = faceNormalAxis[f];
+        int u = faceUAxis[f];
+        int v = faceVAxis[f];
+        bool positive = cubeFaceNormals[f][n] > 0;
+
+        for (int j = 0; j < size; j++)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                int solid = 0;
+                BlockID first = 0;
+                for (int dj = 0; dj < scale; dj++)
+                {
+                    for (int di = 0; di < scale; di++)
+                    {
+                        int p[3];
+                        p[n] = positive ? CHUNK_SIZE : -1;
+                        p[u] = i * scale + di;
+                        p[v] = j * scale + dj;
+
+                        BlockID block = source.get(p[0], p[1], p[2]);
+                        if (block == 0) continue;
+                        solid++;
+                        if (first == 0) first = block;
+                    }
+                }
+                if (solid * 2 < scale * scale) continue;
+
+                int cell[3];
+                cell[n] = positive ? size : -1;
+                cell[u] = i;
+                cell[v] = j;
+                out.set(cell[0], cell[1], cell[2], first);
+            }
+        }
+    }
+
+    // light, brightest sky and block level of each group, border cells from the source border
+    // done for every side (skirts included) so coarse faces are lit like the blocks they stand for
+    auto sourceRange = [&](int c, int& first, int& last)
+    {
+        if (c < 0) { first = last = -1; return; }
+        if (c >= size) { first = last = CHUNK_SIZE; return; }
+        first = c * scale;
+        last = first + scale - 1;
+    };
+    for (int y = -1; y <= size; y++)
+    {
+        int y0, y1;
+        sourceRange(y, y0, y1);
+        for (int z = -1; z <= size; z++)
+        {
+            int z0, z1;
+            sourceRange(z, z0, z1);
+            for (int x = -1; x <= size; x++)
+            {
+                int x0, x1;
+                sourceRange(x, x0, x1);
+                int sky = 0;
+                int blockLight = 0;
+                for (int sy = y0; sy <= y1; sy++)
+                {
+                    for (int sz = z0; sz <= z1; sz++)
+                    {
+                        for (int sx = x0; sx <= x1; sx++)
+                        {
+                            uint8_t light = source.getLight(sx, sy, sz);
+                            sky = std::max(sky, getSkyLight(light));
+                            blockLight = std::max(blockLight, getBlockLight(light));
+                        }
+                    }
+                }
+                out.setLight(x, y, z, (uint8_t)((sky << 4) | blockLight));
+            }
+        }
+    }
+}
+
+FaceConnectivity computeFaceConnectivity(const PaddedBlocks& blocks)
+{
+    // all air, one region touching every face
+    if (blocks.getMinY() > blocks.getMaxY()) return ALL_FACES_CONNECTED;
+
+    // solid cells get marked when first looked at, so each cell is tested once
+    std::vector<uint8_t> seen(CHUNK_VOLUME, 0);
+    std::vector<uint16_t> stack;
+    FaceConnectivity connectivity = 0;
+
+    auto cellIndex = [](int x, int y, int z) { return x + (z * CHUNK_SIZE) + (y * CHUNK_SIZE * CHUNK_SIZE); };
+
+    for (int y = 0; y < CHUNK_SIZE; y++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            for (int x = 0; x < CHUNK_SIZE; x++)
+            {
+                int start = cellIndex(x, y, z);
+                if (seen[start]) continue;
+                seen[start] = 1;
+                if (blocks.isSolid(x, y, z)) continue;
+
+                // one air region, collect the chunk faces it reaches
+                int faces = 0;
+                stack.push_back((uint16_t)start);
+                while (!stack.empty())
+                {
+                    int cell = stack.back();
+                    stack.pop_back();
+                    int cx = cell % CHUNK_SIZE;
+                    int cz = (cell / CHUNK_SIZE) % CHUNK_SIZE;
+                    int cy = cell / (CHUNK_SIZE * CHUNK_SIZE);
+
+                    if (cz == CHUNK_SIZE - 1) faces |= 1 << 0;
+                    if (cz == 0) faces |= 1 << 1;
+                    if (cx == 0) faces |= 1 << 2;
+                    if (cx == CHUNK_SIZE - 1) faces |= 1 << 3;
+                    if (cy == CHUNK_SIZE - 1) faces |= 1 << 4;
+                    if (cy == 0) faces |= 1 << 5;
+
+                    for (int f = 0; f < 6; f++)
+                    {
+                        int nx = cx + cubeFaceNormals[f][0];
+                        int ny = cy + cubeFaceNormals[f][1];
+                        int nz = cz + cubeFaceNormals[f][2];
+                        if (nx < 0 || nx >= CHUNK_SIZE || ny < 0 || ny >= CHUNK_SIZE || nz < 0 || nz >= CHUNK_SIZE) continue;
+
+                        int next = cellIndex(nx, ny, nz);
+                        if (seen[next]) continue;
+                        seen[next] = 1;
+                        if (!blocks.isSolid(nx, ny, nz)) stack.push_back((uint16_t)next);
+                    }
+                }
+
+                for (int a = 0; a < 6; a++)
+                {
+                    if (!(faces & (1 << a))) continue;
+                    for (int b = 0; b < 6; b++)
+                    {
+                        if (faces & (1 << b)) connectivity |= 1ull << (a * 6 + b);
+                    }
+                }
+                if (connectivity == ALL_FACES_CONNECTED) return connectivity;
+            }
+        }
+    }
+    return connectivity;
+}
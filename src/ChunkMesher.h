@@ -0,0 +1,77 @@
+#pragma once
+#include <cstring>
+#include <vector>
+#include "Chunk.h"
+#include "ChunkVertex.h"
+
+constexpr int PADDED_SIZE = CHUNK_SIZE + 2;
+constexpr int PADDED_VOLUME = PADDED_SIZE * PADDED_SIZE * PADDED_SIZE;
+
+// level of detail, a level l mesh is built from cells of (1 << l)^3 blocks
+constexpr int LOD_LEVELS = 4;
+
+// a chunk's blocks plus a 1 block border copied from its neighbours (filled by VoxelWorld)
+// local coords go from -1 to CHUNK_SIZE, so the mesher never bounds checks and
+// faces between two solid blocks in adjacent chunks get culled
+// a downsampled (lod) view uses the same storage with a smaller size, coords -1 to size
+class PaddedBlocks
+{
+public:
+    PaddedBlocks() : m_blocks(PADDED_VOLUME, 0), m_light(PADDED_VOLUME, 0) {}
+
+    // cells per side inside the border, CHUNK_SIZE unless downsampled
+    int getSize() const { return m_size; }
+    void setSize(int size) { m_size = size; }
+
+    // local y range holding the chunk's own solid blocks (not the border), the meshers skip the layers outside it
+    // min > max = nothing to mesh, every layer by default
+    int getMinY() const { return m_minY; }
+    int getMaxY() const { return m_maxY; }
+    void setOccupiedY(int minY, int maxY) { m_minY = minY; m_maxY = maxY; }
+
+    BlockID get(int x, int y, int z) const { return m_blocks[getIndex(x, y, z)]; }
+    void set(int x, int y, int z, BlockID type) { m_blocks[getIndex(x, y, z)] = type; }
+
+    bool isSolid(int x, int y, int z) const { return m_blocks[getIndex(x, y, z)] > 0; }
+
+    // CHUNK_SIZE blocks along x starting at local (0, y, z)
+    void setRow(int y, int z, const BlockID* row) { std::memcpy(&m_blocks[getIndex(0, y, z)], row, CHUNK_SIZE); }
+    // packed sky/block light (see Chunk.h), a face is lit by the block in front of it
+    uint8_t getLight(int x, int y, int z) const { return m_light[getIndex(x, y, z)]; }
+    void setLight(int x, int y, int z, uint8_t light) { m_light[getIndex(x, y, z)] = light; }
+    void setLightRow(int y, int z, const uint8_t* row) { std::memcpy(&m_light[getIndex(0, y, z)], row, CHUNK_SIZE); }
+
+    // PADDED_SIZE blocks along x starting at the border, local (-1, y, z)
+    const BlockID* getPaddedRow(int y, int z) const { return &m_blocks[getIndex(-1, y, z)]; }
+    // every block / light value, indexed with getIndex
+    const BlockID* getBlockData() const { return m_blocks.data(); }
+    const uint8_t* getLightData() const { return m_light.data(); }
+
+    // same layout as Chunk, x + (z * size) + (y * size * size), shifted by the border
+    static int getIndex(int x, int y, int z)
+    {
+        return (x + 1) + ((z + 1) * PADDED_SIZE) + ((y + 1) * PADDED_SIZE * PADDED_SIZE);
+    }
+
+private:
+    std::vector<BlockID> m_blocks;
+    std::vector<uint8_t> m_light;
+    int m_size = CHUNK_SIZE;
+    int m_minY = 0;
+    int m_maxY = CHUNK_SIZE - 1;
+};
+
+// pure CPU mesh build, no GL calls
+// ambientOcclusion darkens face corners next to solid blocks, faces only merge where their corners match
+void buildChunkMesh(const PaddedBlocks& blocks, MeshMode mode, bool ambientOcclusion, std::vector<PackedVertex>& vertices);
+
+// one cell per (1 << lod)^3 block group of a full size view, out must be freshly constructed
+// a cell is solid when at least half its group is, and takes the group's highest solid block so grass tops stay grass
+// the border is downsampled from the source border the same way, so faces between same lod chunks still cull
+// sides in skirtFaces (bit per face index) are left as air instead: the chunk gets its full side wall there (a skirt),
+// which covers the cracks against a neighbour meshed at a different level
+void downsampleBlocks(const PaddedBlocks& source, int lod, int skirtFaces, PaddedBlocks& out);
+
+// flood fills the chunk's air, two faces are connected when one air region touches both
+// only the chunk's own blocks count, the padding is ignored
+FaceConnectivity computeFaceConnectivity(const PaddedBlocks& blocks);
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// packed chunk vertex, 8 bytes (was 5 floats / 20 bytes)
+// data bits: 0-5 x | 6-11 y | 12-17 z | 18-20 face | 21-22 corner | 23-30 atlas tile | 31 unused
+// light bits: 0-3 sky light | 4-7 block light | 8-9 ambient occlusion | rest unused
+// x,y,z are chunk local corner positions (0..32), face uses the Chunk face index map,
+// tile is (flipped atlas row * 16 + column), ambient occlusion is 0 (corner boxed in) to 3 (open)
+// decoded again in assets/shaders/chunk.vert
+struct PackedVertex
+{
+    uint32_t data;
+    uint32_t light;
+};
+
+constexpr int VERTEX_POS_BITS = 6;
+constexpr int VERTEX_FACE_SHIFT = 18;
+constexpr int VERTEX_CORNER_SHIFT = 21;
+constexpr int VERTEX_TILE_SHIFT = 23;
+constexpr int VERTEX_POS_MAX = (1 << VERTEX_POS_BITS) - 1;
+
+struct VertexAttributes
+{
+    int x, y, z;
+    int face;   // 0..5
+    int corner; // 0..3
+    int tile;   // 0..255
+    int skyLight;   // 0..15
+    int blockLight; // 0..15
+    int ao;         // 0..3
+};
+
+constexpr PackedVertex packVertex(int x, int y, int z, int face, int corner, int tile, int skyLight = 0, int blockLight = 0, int ao = 3)
+{
+    return {
+        (uint32_t)(x & 0x3F)
+            | ((uint32_t)(y & 0x3F) << VERTEX_POS_BITS)
+            | ((uint32_t)(z & 0x3F) << (VERTEX_POS_BITS * 2))
+            | ((uint32_t)(face & 0x7) << VERTEX_FACE_SHIFT)
+            | ((uint32_t)(corner & 0x3) << VERTEX_CORNER_SHIFT)
+            | ((uint32_t)(tile & 0xFF) << VERTEX_TILE_SHIFT),
+        (uint32_t)(skyLight & 0xF) | ((uint32_t)(blockLight & 0xF) << 4) | ((uint32_t)(ao & 0x3) << 8)
+    };
+}
+
+constexpr VertexAttributes unpackVertex(PackedVertex v)
+{
+    return {
+        (int)(v.data & 0x3F),
+        (int)((v.data >> VERTEX_POS_BITS) & 0x3F),
+        (int)((v.data >> (VERTEX_POS_BITS * 2)) & 0x3F),
+        (int)((v.data >> VERTEX_FACE_SHIFT) & 0x7),
+        (int)((v.data >> VERTEX_CORNER_SHIFT) & 0x3),
+        (int)((v.data >> VERTEX_TILE_SHIFT) & 0xFF),
+        (int)(v.light & 0xF),
+        (int)((v.light >> 4) & 0xF),
+        (int)((v.light >> 8) & 0x3)
+    };
+}
+
+// chunk local box around every vertex of a mesh, min > max when the mesh is empty
+struct MeshBounds
+{
+    int minX = VERTEX_POS_MAX, minY = VERTEX_POS_MAX, minZ = VERTEX_POS_MAX;
+    int maxX = 0, maxY = 0, maxZ = 0;
+
+    bool isEmpty() const { return minX > maxX; }
+};
+
+inline MeshBounds computeMeshBounds(const PackedVertex* vertices, size_t count)
+{
+    MeshBounds bounds;
+    for (size_t i = 0; i < count; i++)
+    {
+        VertexAttributes v = unpackVertex(vertices[i]);
+        if (v.x < bounds.minX) bounds.minX = v.x;
+        if (v.y < bounds.minY) bounds.minY = v.y;
+        if (v.z < bounds.minZ) bounds.minZ = v.z;
+        if (v.x > bounds.maxX) bounds.maxX = v.x;
+        if (v.y > bounds.maxY) bounds.maxY = v.y;
+        if (v.z > bounds.maxZ) bounds.maxZ = v.z;
+    }
+    return bounds;
+}
+
+// round trip is checked at compile time, no GL needed
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255)).x == 32);
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255)).z == 17);
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255)).face == 5);
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255)).corner == 3);
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255)).tile == 255);
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255, 15, 7)).skyLight == 15);
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255, 15, 7)).blockLight == 7);
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255, 15, 7, 1)).ao == 1);
+static_assert(unpackVertex(packVertex(32, 0, 17, 5, 3, 255)).ao == 3);
+static_assert(sizeof(PackedVertex) == 8);
@@ -1,53 +1,35 @@
 #pragma once
 
-// Format: x, y, z, u, v
-// Coordinates: 0.0 to 1.0 (Fixes alignment with Raycast/Outline)
-const float cubeVertices[] = {
+// Format: x, y, z of the 4 corners of each face, drawn as triangles 0,1,2 and 2,3,0 (see QuadIndexBuffer)
+// Coordinates: 0 to 1 (Fixes alignment with Raycast/Outline)
+// face index map: 0=front, 1=back, 2=left, 3=right, 4=top, 5=bottom
+const int cubeFaceCorners[6][4][3] = {
     // Front Face (Z=1)
-    0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
-    1.0f, 0.0f, 1.0f, 1.0f, 0.0f,
-    1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-    1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-    0.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+    { {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1} },
 
     // Back Face (Z=0)
-    1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-    0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-    0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
-    0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
-    1.0f, 1.0f, 0.0f, 0.0f, 1.0f,
-    1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    { {1, 0, 0}, {0, 0, 0}, {0, 1, 0}, {1, 1, 0} },
 
     // Left Face (X=0)
-    0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-    0.0f, 0.0f, 1.0f, 1.0f, 0.0f,
-    0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-    0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-    0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    { {0, 0, 0}, {0, 0, 1}, {0, 1, 1}, {0, 1, 0} },
 
     // Right Face (X=1)
-    1.0f, 0.0f, 1.0f, 0.0f, 0.0f,
-    1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-    1.0f, 1.0f, 0.0f, 1.0f, 1.0f,
-    1.0f, 1.0f, 0.0f, 1.0f, 1.0f,
-    1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-    1.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+    { {1, 0, 1}, {1, 0, 0}, {1, 1, 0}, {1, 1, 1} },
 
     // Top Face (Y=1)
-    0.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-    1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-    1.0f, 1.0f, 0.0f, 1.0f, 1.0f,
-    1.0f, 1.0f, 0.0f, 1.0f, 1.0f,
-    0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
-    0.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+    { {0, 1, 1}, {1, 1, 1}, {1, 1, 0}, {0, 1, 0} },
 
     // Bottom Face (Y=0)
-    0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-    1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-    1.0f, 0.0f, 1.0f, 1.0f, 1.0f,
-    1.0f, 0.0f, 1.0f, 1.0f, 1.0f,
-    0.0f, 0.0f, 1.0f, 0.0f, 1.0f, // <--- Corrected this vertex!
-    0.0f, 0.0f, 0.0f, 0.0f, 0.0f
-};
\ No newline at end of file
+    { {0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1} }
+};
+
+// direction each face points, also the step to the neighbouring block / chunk on that side
+// opposite faces are paired, face ^ 1 is the one facing the other way
+const int cubeFaceNormals[6][3] = {
+    { 0,  0,  1}, // front--(Z+)
+    { 0,  0, -1}, // back---(Z-)
+    {-1,  0,  0}, // left---(X-)
+    { 1,  0,  0}, // right--(X+)
+    { 0,  1,  0}, // top----(Y+)
+    { 0, -1,  0}  // bottom-(Y-)
+};
@@ -0,0 +1,307 @@
+#include "EntityStore.h"
+#include "Physics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+EntityStore::EntityStore(TaskScheduler& scheduler)
+    : m_scheduler(scheduler)
+{
+}
+
+EntityId EntityStore::spawn(glm::vec3 position, glm::vec3 halfExtents, glm::vec3 velocity)
+{
+    uint32_t slot;
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = (uint32_t)m_indices.size();
+        m_indices.push_back(INVALID_INDEX);
+        m_generations.push_back(0);
+    }
+
+    EntityId id = ((EntityId)m_generations[slot] << ENTITY_SLOT_BITS) | slot;
+    m_indices[slot] = (uint32_t)m_positions.size();
+    m_positions.push_back(position);
+    m_velocities.push_back(velocity);
+    m_halfExtents.push_back(halfExtents);
+    m_onGround.push_back(0);
+    m_ids.push_back(id);
+    return id;
+}
+
+bool EntityStore::contains(EntityId id) const
+{
+    uint32_t slot = id & ENTITY_SLOT_MASK;
+    return slot < m_indices.size() && m_indices[slot] != INVALID_INDEX && m_generations[slot] == id >> ENTITY_SLOT_BITS;
+}
+
+void EntityStore::despawn(EntityId id)
+{
+    if (!contains(id)) return;
+
+    uint32_t slot = id & ENTITY_SLOT_MASK;
+    uint32_t index = m_indices[slot];
+    uint32_t last = (uint32_t)m_positions.size() - 1;
+    if (index != last)
+    {
+        m_positions[index] = m_positions[last];
+        m_velocities[index] = m_velocities[last];
+        m_halfExtents[index] = m_halfExtents[last];
+        m_onGround[index] = m_onGround[last];
+        m_ids[index] = m_ids[last];
+        m_indices[m_ids[index] & ENTITY_SLOT_MASK] = index;
+    }
+    m_positions.pop_back();
+    m_velocities.pop_back();
+    m_halfExtents.pop_back();
+    m_onGround.pop_back();
+    m_ids.pop_back();
+
+    m_indices[slot] = INVALID_INDEX;
+    m_generations[slot]++; // wraps, uint8_t
+    m_freeSlots.push_back(slot);
+}
+
+void EntityStore::clear()
+{
+    m_positions.clear();
+    m_velocities.clear();
+    m_halfExtents.clear();
+    m_onGround.clear();
+    m_ids.clear();
+
+    // every slot is free again, live ones move to their next generation so the ids handed out so far stay stale
+    m_freeSlots.clear();
+    for (uint32_t slot = (uint32_t)m_indices.size(); slot-- > 0;)
+    {
+        if (m_indices[slot] != INVALID_INDEX) m_generations[slot]++;
+        m_indices[slot] = INVALID_INDEX;
+        m_freeSlots.push_back(slot);
+    }
+}
+
+void EntityStore::step(float deltaTime, const VoxelWorld& world)
+{
+    m_accumulator += std::min(deltaTime, MAX_FRAME_TIME);
+    while (m_accumulator >= FIXED_TIMESTEP)
+    {
+        tick(world);
+        m_accumulator -= FIXED_TIMESTEP;
+    }
+}
+
+template <typename Body>
+void EntityStore::forEachBatch(const Body& body)
+{
+    size_t count = m_positions.size();
+    int batches = (int)getBatchCount();
+    if (batches <= 1)
+    {
+        // not worth waking the workers
+        if (count > 0) body(0, (size_t)0, count);
+        return;
+    }
+
+    m_scheduler.parallelFor(batches, [&](int batch)
+    {
+        size_t begin = (size_t)batch * BATCH_SIZE;
+        body(batch, begin, std::min(begin + BATCH_SIZE, count));
+    });
+}
+
+void EntityStore::tick(const VoxelWorld& world)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // 1- move against the world
+    forEachBatch([&](int, size_t begin, size_t end) { integrate(begin, end, world); });
+
+    // 2- who is near who
+    buildBroadphase();
+    if (++m_ticksSinceReorder >= REORDER_INTERVAL)
+    {
+        sortByCell();
+        m_ticksSinceReorder = 0;
+    }
+
+    // 3- push overlapping pairs apart
+    m_batchContacts.assign(getBatchCount(), 0);
+    forEachBatch([&](int batch, size_t begin, size_t end) { m_batchContacts[batch] = resolveContacts(begin, end); });
+    m_contactCount = 0;
+    for (size_t contacts : m_batchContacts) m_contactCount += contacts;
+
+    // fell out of the world, back to front so the swapped in entities were already checked
+    for (size_t i = m_positions.size(); i-- > 0;)
+    {
+        if (m_positions[i].y < KILL_HEIGHT) despawn(m_ids[i]);
+    }
+
+    m_lastTickMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void EntityStore::integrate(size_t begin, size_t end, const VoxelWorld& world)
+{
+    // y first so landing is settled before sliding, same as the player
+    const int axes[3] = { 1, 0, 2 };
+
+    for (size_t i = begin; i < end; i++)
+    {
+        glm::vec3 position = m_positions[i];
+        if (!world.isColumnLoaded((int)std::floor(position.x), (int)std::floor(position.z)))
+        {
+            // no ground under it yet, wait instead of falling through
+            m_velocities[i] = glm::vec3(0.0f);
+            continue;
+        }
+
+        glm::vec3 velocity = m_velocities[i];
+        if (m_onGround[i])
+        {
+            velocity.x *= GROUND_FRICTION;
+            velocity.z *= GROUND_FRICTION;
+        }
+        velocity.y -= GRAVITY * FIXED_TIMESTEP;
+
+        glm::vec3 half = m_halfExtents[i];
+        glm::vec3 boxMin = position - half;
+        glm::vec3 boxMax = position + half;
+        glm::vec3 delta = velocity * FIXED_TIMESTEP;
+
+        bool onGround = false;
+        for (int axis : axes)
+        {
+            float moved = sweepBox(boxMin, boxMax, axis, delta[axis], SKIN, world);
+            if (moved == delta[axis]) continue;
+
+            if (axis == 1 && delta.y < 0.0f) onGround = true;
+            velocity[axis] = 0.0f;
+        }
+
+        m_positions[i] = boxMin + half;
+        m_velocities[i] = velocity;
+        m_onGround[i] = onGround;
+    }
+}
+
+uint32_t EntityStore::bucketOf(glm::ivec3 cell) const
+{
+    // rows of cells along x go to runs of buckets, a query walks neighbouring starts instead of random ones
+    // and after sortByCell the entities of a row sit together too
+    uint32_t row = ((uint32_t)cell.y * 19349663u) ^ ((uint32_t)cell.z * 83492791u);
+    return (row + (uint32_t)cell.x) & m_bucketMask;
+}
+
+void EntityStore::buildBroadphase()
+{
+    size_t count = m_positions.size();
+
+    // power of two buckets, about two per entity
+    size_t bucketCount = 64;
+    while (bucketCount < count * 2) bucketCount *= 2;
+    m_bucketStarts.assign(bucketCount + 1, 0);
+    m_bucketMask = (uint32_t)bucketCount - 1;
+
+    m_cells.resize(count);
+    m_buckets.resize(count);
+    m_maxHalfExtents = glm::vec3(0.0f);
+    for (size_t i = 0; i < count; i++)
+    {
+        m_maxHalfExtents = glm::max(m_maxHalfExtents, m_halfExtents[i]);
+        glm::ivec3 cell = glm::ivec3(glm::floor(m_positions[i] / CONTACT_CELL_SIZE));
+        m_cells[i] = cell;
+        m_buckets[i] = bucketOf(cell);
+        m_bucketStarts[m_buckets[i]]++;
+    }
+
+    // counting sort, the running sum leaves each start at its bucket's end
+    // placing back to front moves it to the bucket's begin and keeps entities in index order
+    uint32_t sum = 0;
+    for (size_t b = 0; b <= bucketCount; b++)
+    {
+        sum += m_bucketStarts[b];
+        m_bucketStarts[b] = sum;
+    }
+    m_bucketEntities.resize(count);
+    for (size_t i = count; i-- > 0;)
+    {
+        m_bucketEntities[--m_bucketStarts[m_buckets[i]]] = (uint32_t)i;
+    }
+}
+
+template <typename T>
+static void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+{
+    std::vector<T> sorted(values.size());
+    for (size_t k = 0; k < order.size(); k++) sorted[k] = values[order[k]];
+    values.swap(sorted);
+}
+
+void EntityStore::sortByCell()
+{
+    permute(m_positions, m_bucketEntities);
+    permute(m_velocities, m_bucketEntities);
+    permute(m_halfExtents, m_bucketEntities);
+    permute(m_onGround, m_bucketEntities);
+    permute(m_ids, m_bucketEntities);
+    permute(m_cells, m_bucketEntities);
+
+    for (size_t k = 0; k < m_ids.size(); k++)
+    {
+        m_indices[m_ids[k] & ENTITY_SLOT_MASK] = (uint32_t)k;
+        m_bucketEntities[k] = (uint32_t)k;
+    }
+}
+
+size_t EntityStore::resolveContacts(size_t begin, size_t end)
+{
+    size_t contacts = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        glm::vec3 position = m_positions[i];
+        glm::vec3 half = m_halfExtents[i];
+        glm::vec3 push(0.0f);
+
+        // any box overlapping this one has its center less than half + the largest half extents away
+        glm::vec3 reach = half + m_maxHalfExtents;
+        glm::ivec3 first = glm::ivec3(glm::floor((position - reach) / CONTACT_CELL_SIZE));
+        glm::ivec3 last = glm::ivec3(glm::floor((position + reach) / CONTACT_CELL_SIZE));
+
+        for (int y = first.y; y <= last.y; y++)
+        {
+            for (int z = first.z; z <= last.z; z++)
+            {
+                for (int x = first.x; x <= last.x; x++)
+                {
+                    glm::ivec3 neighbor(x, y, z);
+                    uint32_t bucket = bucketOf(neighbor);
+                    for (uint32_t k = m_bucketStarts[bucket]; k < m_bucketStarts[bucket + 1]; k++)
+                    {
+                        uint32_t j = m_bucketEntities[k];
+                        // entities of another cell in the same bucket, that cell is looked at on its own
+                        if (j == i || m_cells[j] != neighbor) continue;
+
+                        glm::vec3 offset = position - m_positions[j];
+                        glm::vec3 overlap = half + m_halfExtents[j] - glm::abs(offset);
+                        if (overlap.x <= 0.0f || overlap.y <= 0.0f || overlap.z <= 0.0f) continue;
+                        if (j > i) contacts++;
+
+                        // sideways along the shallower axis, the pair gets the same push in opposite directions
+                        // entities on the exact same spot split by index
+                        int axis = overlap.x < overlap.z ? 0 : 2;
+                        float side = offset[axis] != 0.0f ? (offset[axis] > 0.0f ? 1.0f : -1.0f) : (i < j ? -1.0f : 1.0f);
+                        push[axis] += side * overlap[axis];
+                    }
+                }
+            }
+        }
+
+        // only entity i is written, the positions every thread reads dont change in this pass
+        m_velocities[i] += push * CONTACT_STIFFNESS;
+    }
+    return contacts;
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "TaskScheduler.h"
+#include "VoxelWorld.h"
+
+// handed out by spawn, stays valid until despawn while the entity's index moves around
+// low ENTITY_SLOT_BITS = slot (16M entities at once), freed slots are handed out again, high bits = how many times the slot was reused
+// so an id kept past its despawn doesnt reach the entity that took the slot (until the generation wraps at 256 reuses)
+using EntityId = uint32_t;
+constexpr int ENTITY_SLOT_BITS = 24;
+constexpr EntityId ENTITY_SLOT_MASK = (1u << ENTITY_SLOT_BITS) - 1;
+
+// mobs and items, stored as structure of arrays: one vector per component, index i in each is entity i
+// a tick runs in three passes
+//   1- gravity and swept collision against the voxel world, in parallel batches
+//   2- spatial hash of the entity boxes, entities counting sorted by cell
+//   3- overlapping entities pushed apart through velocity, in parallel batches
+// every pass writes only its own entity's slots, so the result doesnt depend on the thread count
+class EntityStore
+{
+public:
+    // Constants
+    const float GRAVITY = 18.0f;
+    const float FIXED_TIMESTEP = 1.0f / 60.0f;
+    const float MAX_FRAME_TIME = 0.25f;
+    const float SKIN = 0.001f;
+    // horizontal speed kept per tick while on the ground
+    const float GROUND_FRICTION = 0.85f;
+    // separating speed per block of overlap, contacts ease apart over a few ticks instead of popping
+    const float CONTACT_STIFFNESS = 10.0f;
+    // entities below this are out of the world and get removed
+    const float KILL_HEIGHT = -64.0f;
+
+    // broadphase cell edge, an entity looks through the cells its box could reach the center of another in
+    // (its half extents plus the largest in the store), one to three per axis for mob and item sizes
+    const float CONTACT_CELL_SIZE = 2.0f;
+    // entities per parallel task
+    const size_t BATCH_SIZE = 1024;
+    // ticks between reorders of the components into broadphase order, see sortByCell
+    const int REORDER_INTERVAL = 30;
+
+    // the passes run on scheduler, the calling thread helps and waits for them
+    explicit EntityStore(TaskScheduler& scheduler);
+
+    // position = box center
+    EntityId spawn(glm::vec3 position, glm::vec3 halfExtents, glm::vec3 velocity = glm::vec3(0.0f));
+    // swaps the last entity into the hole, a stale id does nothing
+    void despawn(EntityId id);
+    // spawned and not despawned yet
+    bool contains(EntityId id) const;
+    // despawns everything, ids from before stay stale like after despawn
+    void clear();
+
+    // update, runs the fixed ticks deltaTime adds up to
+    void step(float deltaTime, const VoxelWorld& world);
+    // one tick, entities over columns that arent loaded wait where they are
+    void tick(const VoxelWorld& world);
+
+    size_t size() const { return m_positions.size(); }
+    // components, dense, index i = the i-th entity
+    const std::vector<glm::vec3>& getPositions() const { return m_positions; }
+    const std::vector<glm::vec3>& getVelocities() const { return m_velocities; }
+    const std::vector<glm::vec3>& getHalfExtents() const { return m_halfExtents; }
+
+    // overlapping pairs found in the last tick and how long it took
+    size_t getContactCount() const { return m_contactCount; }
+    double getLastTickMs() const { return m_lastTickMs; }
+
+private:
+    TaskScheduler& m_scheduler;
+
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_velocities;
+    std::vector<glm::vec3> m_halfExtents;
+    std::vector<uint8_t> m_onGround;
+    std::vector<EntityId> m_ids;
+
+    // slot -> index, INVALID_INDEX once despawned, freed slots are handed out again with the next generation
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+    std::vector<uint32_t> m_indices;
+    std::vector<uint8_t> m_generations;
+    std::vector<uint32_t> m_freeSlots;
+
+    // broadphase, rebuilt every tick
+    // entities of bucket b are m_bucketEntities[m_bucketStarts[b] .. m_bucketStarts[b + 1]]
+    // a bucket can hold several cells, m_cells tells them apart
+    // m_maxHalfExtents = largest half extents on each axis, how far beyond its own box an entity has to look
+    std::vector<glm::ivec3> m_cells;
+    std::vector<uint32_t> m_buckets;
+    std::vector<uint32_t> m_bucketStarts;
+    std::vector<uint32_t> m_bucketEntities;
+    uint32_t m_bucketMask = 0;
+    glm::vec3 m_maxHalfExtents{ 0.0f };
+    std::vector<size_t> m_batchContacts;
+
+    float m_accumulator = 0.0f;
+    int m_ticksSinceReorder = 0;
+    size_t m_contactCount = 0;
+    double m_lastTickMs = 0.0;
+
+    // pass 1 for entities begin..end-1
+    void integrate(size_t begin, size_t end, const VoxelWorld& world);
+    // pass 2
+    void buildBroadphase();
+    // moves every component into m_bucketEntities order, entities sharing a cell end up next to each other
+    // so the contact pass reads runs of memory instead of jumping around the arrays, ids keep pointing at their entity
+    void sortByCell();
+    // pass 3 for entities begin..end-1, returns the pairs found with a higher index
+    size_t resolveContacts(size_t begin, size_t end);
+    // runs body(batch, begin, end) on every BATCH_SIZE range of entities across the scheduler
+    template <typename Body>
+    void forEachBatch(const Body& body);
+    size_t getBatchCount() const { return (m_positions.size() + BATCH_SIZE - 1) / BATCH_SIZE; }
+
+    uint32_t bucketOf(glm::ivec3 cell) const;
+};
@@ -0,0 +1,86 @@
+#include "FreeListAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+FreeListAllocator::FreeListAllocator(size_t capacity)
+{
+    grow(capacity);
+}
+
+size_t FreeListAllocator::allocate(size_t size)
+{
+    if (size == 0) return INVALID;
+
+    for (auto it = m_free.begin(); it != m_free.end(); ++it)
+    {
+        if (it->second < size) continue;
+
+        // take the front of the block, the rest stays free
+        size_t offset = it->first;
+        size_t remaining = it->second - size;
+        m_free.erase(it);
+        if (remaining > 0) m_free.emplace(offset + size, remaining);
+
+        m_used += size;
+        return offset;
+    }
+    return INVALID;
+}
+
+void FreeListAllocator::free(size_t offset, size_t size)
+{
+    if (size == 0) return;
+    assert(offset + size <= m_capacity);
+    assert(m_used >= size);
+
+    m_used -= size;
+    insertFree(offset, size);
+}
+
+void FreeListAllocator::grow(size_t newCapacity)
+{
+    if (newCapacity <= m_capacity) return;
+
+    size_t added = newCapacity - m_capacity;
+    size_t offset = m_capacity;
+    m_capacity = newCapacity;
+    insertFree(offset, added);
+}
+
+size_t FreeListAllocator::getLargestFreeBlock() const
+{
+    size_t largest = 0;
+    for (const auto& [offset, size] : m_free) largest = std::max(largest, size);
+    return largest;
+}
+
+void FreeListAllocator::insertFree(size_t offset, size_t size)
+{
+    auto next = m_free.lower_bound(offset);
+
+    // merge with the block before if it ends right here
+    if (next != m_free.begin())
+    {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= offset); // double free or overlap
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            m_free.erase(prev);
+        }
+    }
+
+    // and with the block after if it starts right at the end
+    if (next != m_free.end())
+    {
+        assert(offset + size <= next->first);
+        if (offset + size == next->first)
+        {
+            size += next->second;
+            m_free.erase(next);
+        }
+    }
+
+    m_free.emplace(offset, size);
+}
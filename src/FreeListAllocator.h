@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+// first fit range allocator over [0, capacity), it hands out offsets and owns no memory
+// free blocks are kept sorted by offset and merged with their neighbours when freed
+// used by ChunkMeshArena to place meshes in one GPU buffer, but knows nothing about GL
+class FreeListAllocator
+{
+public:
+    static constexpr size_t INVALID = SIZE_MAX;
+
+    explicit FreeListAllocator(size_t capacity = 0);
+
+    // offset of a free run of size units, INVALID if no free block is big enough
+    size_t allocate(size_t size);
+    // size must match the allocate call
+    void free(size_t offset, size_t size);
+
+    // adds [capacity, newCapacity) as free space, existing offsets stay valid
+    void grow(size_t newCapacity);
+
+    size_t getCapacity() const { return m_capacity; }
+    size_t getUsed() const { return m_used; }
+    size_t getFreeBlockCount() const { return m_free.size(); }
+    size_t getLargestFreeBlock() const;
+
+private:
+    std::map<size_t, size_t> m_free; // offset -> size
+    size_t m_capacity = 0;
+    size_t m_used = 0;
+
+    // inserts a free block and merges it with the blocks right before and after it
+    void insertFree(size_t offset, size_t size);
+};
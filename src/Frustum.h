@@ -0,0 +1,41 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// six planes pulled straight out of a projection * view matrix (Gribb/Hartmann)
+// plane = (normal, distance), normals point inside, a point is inside when dot(n, p) + d >= 0
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection)
+    {
+        // glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+        auto row = [&viewProjection](int i)
+        {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+
+        Frustum frustum;
+        frustum.planes[0] = row(3) + row(0); // left
+        frustum.planes[1] = row(3) - row(0); // right
+        frustum.planes[2] = row(3) + row(1); // bottom
+        frustum.planes[3] = row(3) - row(1); // top
+        frustum.planes[4] = row(3) + row(2); // near
+        frustum.planes[5] = row(3) - row(2); // far
+        return frustum;
+    }
+
+    // conservative, a box near a frustum corner can pass without being visible
+    bool intersectsBox(glm::vec3 min, glm::vec3 max) const
+    {
+        for (const glm::vec4& plane : planes)
+        {
+            // the box corner furthest along the plane normal
+            glm::vec3 positive(plane.x >= 0.0f ? max.x : min.x,
+                               plane.y >= 0.0f ? max.y : min.y,
+                               plane.z >= 0.0f ? max.z : min.z);
+            if (plane.x * positive.x + plane.y * positive.y + plane.z * positive.z + plane.w < 0.0f) return false;
+        }
+        return true;
+    }
+};
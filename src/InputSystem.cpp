@@ -1,5 +1,7 @@
 #include "InputSystem.h"
+#include <cmath>
 #include <iostream>
+#include <random>
 
 // global pointer for static callback to find cam instance
 static InputSystem* g_InputSystem = nullptr;
@@ -10,6 +12,9 @@ InputSystem::InputSystem()
       m_isLeftMousePressed(false), 
       m_isRightMousePressed(false), 
       m_isCPressed(false),
+      m_isMPressed(false),
+      m_isOPressed(false),
+      m_isEPressed(false),
       m_firstMouse(true),
       m_lastX(1280.0f / 2.0f),
       m_lastY(720.0f / 2.0f)
@@ -52,7 +57,7 @@ void InputSystem::onMouseMovement(double xposIn, double yposIn) {
     g_CameraPtr->ProcessMouseMovement(xoffset, yoffset);
 }
 
-void InputSystem::processInput(GLFWwindow* window, float deltaTime, VoxelWorld& world, Physics& physics, Camera& camera)
+void InputSystem::processInput(GLFWwindow* window, float deltaTime, VoxelWorld& world, Physics& physics, Camera& camera, const RaycastResult& target, EntityStore& entities)
 {
     // update global cam
     g_CameraPtr = &camera;
@@ -73,16 +78,70 @@ void InputSystem::processInput(GLFWwindow* window, float deltaTime, VoxelWorld&
         m_isCPressed = false;
     }
 
+    // MESHER TOGGLE
+    // m, cycle naive -> greedy -> binary to compare them on the same world
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !m_isMPressed)
+    {
+        m_isMPressed = true;
+        MeshMode mode = world.getMeshMode();
+        if (mode == MeshMode::Naive) world.setMeshMode(MeshMode::Greedy);
+        else if (mode == MeshMode::Greedy) world.setMeshMode(MeshMode::Binary);
+        else world.setMeshMode(MeshMode::Naive);
+    }
+    else if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE)
+    {
+        m_isMPressed = false;
+    }
+
+    // AMBIENT OCCLUSION TOGGLE
+    // o, rebuild with and without it, the rebuild log shows what it costs the mesher
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS && !m_isOPressed)
+    {
+        m_isOPressed = true;
+        world.setAmbientOcclusion(!world.getAmbientOcclusion());
+    }
+    else if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE)
+    {
+        m_isOPressed = false;
+    }
+
+    // ENTITIES
+    // e, drops 1000 mobs and items over the ground in front of the player
+    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS && !m_isEPressed)
+    {
+        m_isEPressed = true;
+        static std::mt19937 rng(1);
+        std::uniform_real_distribution<float> spread(-8.0f, 8.0f);
+        glm::vec3 front = glm::normalize(glm::vec3(camera.Front.x, 0.0f, camera.Front.z));
+        glm::vec3 center = camera.Position + front * 12.0f;
+        for (int i = 0; i < 1000; i++)
+        {
+            glm::vec3 position(center.x + spread(rng), 0.0f, center.z + spread(rng));
+            int ground = world.getSurfaceHeight((int)std::floor(position.x), (int)std::floor(position.z));
+            if (ground < 0) continue;
+            position.y = ground + 4.0f + (i % 16);
+            glm::vec3 half = i % 4 == 0 ? glm::vec3(0.3f, 0.9f, 0.3f) : glm::vec3(0.125f);
+            entities.spawn(position, half);
+        }
+        std::cout << "entities: " << entities.size() << std::endl;
+    }
+    else if (glfwGetKey(window, GLFW_KEY_E) == GLFW_RELEASE)
+    {
+        m_isEPressed = false;
+    }
+
     // HOTBAR
     // 1,2,3
     if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) m_selectedBlockID = 1;
     if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) m_selectedBlockID = 2;
     if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) m_selectedBlockID = 3;
+    if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) m_selectedBlockID = 4;
 
     // MOVE MF
     // wasd, space, ctrl, shift
-    float velocity = 10.0f * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) velocity *= 2.0f;
+    // walking speed is in blocks per second, physics applies it in its own fixed ticks
+    float speed = 10.0f;
+    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) speed *= 2.0f;
 
     if (camera.flying_mode)
     {
@@ -106,10 +165,10 @@ void InputSystem::processInput(GLFWwindow* window, float deltaTime, VoxelWorld&
         if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) moveDir -= right;
         if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) moveDir += right;
 
-        physics.move(moveDir, velocity, world, camera);
+        physics.move(moveDir, speed);
 
         if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-            physics.jump(world, camera);
+            physics.jump();
         }
     }
 
@@ -119,10 +178,9 @@ void InputSystem::processInput(GLFWwindow* window, float deltaTime, VoxelWorld&
     if (stateLeft == GLFW_PRESS && !m_isLeftMousePressed)
     {
         m_isLeftMousePressed = true;
-        RaycastResult result = physics.raycast(camera.Position, camera.Front, 8.0f, world);
-        if (result.hit)
+        if (target.hit)
         {
-            world.setBlock(result.x, result.y, result.z, 0); // air
+            world.setBlock(target.x, target.y, target.z, 0); // air
         }
     }
     else if (stateLeft == GLFW_RELEASE)
@@ -135,12 +193,11 @@ void InputSystem::processInput(GLFWwindow* window, float deltaTime, VoxelWorld&
     if (stateRight == GLFW_PRESS && !m_isRightMousePressed)
     {
         m_isRightMousePressed = true;
-        RaycastResult result = physics.raycast(camera.Position, camera.Front, 8.0f, world);
-        if (result.hit)
+        if (target.hit)
         {
-            int newX = result.x + (int)result.normal.x;
-            int newY = result.y + (int)result.normal.y;
-            int newZ = result.z + (int)result.normal.z;
+            int newX = target.x + (int)target.normal.x;
+            int newY = target.y + (int)target.normal.y;
+            int newZ = target.z + (int)target.normal.z;
 
             // dont place inside
             float dist = glm::distance(camera.Position, glm::vec3(newX + 0.5f, newY + 0.5f, newZ + 0.5f));
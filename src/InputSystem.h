@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 #include "VoxelWorld.h"
 #include "Physics.h"
+#include "EntityStore.h"
 #include "Camera.h"
 
 class InputSystem
@@ -13,7 +14,8 @@ public:
     // glfw callbacks
     void setupCallbacks(GLFWwindow* window);
 
-    void processInput(GLFWwindow* window, float deltaTime, VoxelWorld& world, Physics& physics, Camera& camera);
+    // target = block under the crosshair, cast once per frame by the caller (the one the outline shows)
+    void processInput(GLFWwindow* window, float deltaTime, VoxelWorld& world, Physics& physics, Camera& camera, const RaycastResult& target, EntityStore& entities);
 
     // getter
     int getSelectedBlockID() const { return m_selectedBlockID; }
@@ -24,6 +26,9 @@ private:
     bool m_isLeftMousePressed;
     bool m_isRightMousePressed;
     bool m_isCPressed;
+    bool m_isMPressed;
+    bool m_isOPressed;
+    bool m_isEPressed;
 
     // mouse look
     bool m_firstMouse;
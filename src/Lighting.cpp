@@ -0,0 +1,193 @@
+#include "Lighting.h"
+
+namespace
+{
+// same layout as Chunk, x + (z * size) + (y * size * size)
+int lightIndex(int x, int y, int z)
+{
+    return x + (z * CHUNK_SIZE) + (y * CHUNK_SIZE * CHUNK_SIZE);
+}
+
+// one column in world y and chunk local x,z, nothing outside it is lit
+// stone sections under solidSections are dark, missing sections above are air in full sky
+// light is written to flat per section arrays (lights[cy], empty = none yet) and packed into the chunks once at the end
+// block light reaching a missing air section allocates it
+class ColumnLightAccess
+{
+public:
+    ColumnLightAccess(std::vector<std::pair<int, std::unique_ptr<Chunk>>>& sections, Chunk** byY,
+                      std::vector<std::vector<uint8_t>>& lights, int solidSections, int sectionCount)
+        : m_sections(sections), m_byY(byY), m_lights(lights), m_solidSections(solidSections), m_sectionCount(sectionCount)
+    {
+    }
+
+    bool getCell(int x, int y, int z, BlockID& block, uint8_t& light) const
+    {
+        if (x < 0 || x >= CHUNK_SIZE || z < 0 || z >= CHUNK_SIZE) return false;
+        if (y < 0 || y >= m_sectionCount * CHUNK_SIZE) return false;
+
+        int cy = y / CHUNK_SIZE;
+        if (const Chunk* chunk = m_byY[cy])
+        {
+            block = chunk->getBlock(x, y % CHUNK_SIZE, z);
+            light = m_lights[cy][lightIndex(x, y % CHUNK_SIZE, z)];
+        }
+        else
+        {
+            block = cy < m_solidSections ? 3 : 0;
+            light = block == 0 ? FULL_SKY_LIGHT : 0;
+        }
+        return true;
+    }
+
+    void setLight(int x, int y, int z, uint8_t light)
+    {
+        int cy = y / CHUNK_SIZE;
+        if (!m_byY[cy])
+        {
+            auto chunk = std::make_unique<Chunk>();
+            m_byY[cy] = chunk.get();
+            m_sections.emplace_back(cy, std::move(chunk));
+            m_lights[cy].assign(CHUNK_VOLUME, FULL_SKY_LIGHT);
+        }
+        m_lights[cy][lightIndex(x, y % CHUNK_SIZE, z)] = light;
+    }
+
+private:
+    std::vector<std::pair<int, std::unique_ptr<Chunk>>>& m_sections;
+    Chunk** m_byY;
+    std::vector<std::vector<uint8_t>>& m_lights;
+    int m_solidSections;
+    int m_sectionCount;
+};
+}
+
+size_t lightColumn(std::vector<std::pair<int, std::unique_ptr<Chunk>>>& sections, int solidSections, int sectionCount)
+{
+    std::vector<Chunk*> byY(sectionCount, nullptr);
+    std::vector<std::vector<uint8_t>> lights(sectionCount);
+    for (auto& [cy, chunk] : sections)
+    {
+        byY[cy] = chunk.get();
+        lights[cy].resize(CHUNK_VOLUME);
+        chunk->copyLight(lights[cy].data());
+    }
+
+    // 1- sunlight straight down from the top until the first solid block, from the heightmaps
+    // an air section with blocks above it is allocated so it can hold its shadow
+    // caves = air under a column's top block, only those need the sideways fill below
+    std::array<bool, CHUNK_SIZE * CHUNK_SIZE> shadowed{};
+    bool anyShadowed = false;
+    bool hasCaves = false;
+    for (int cy = sectionCount - 1; cy >= 0; cy--)
+    {
+        Chunk* chunk = byY[cy];
+        if (!chunk && cy < solidSections)
+        {
+            // implicit stone, nothing under it sees the sky
+            shadowed.fill(true);
+            anyShadowed = true;
+            continue;
+        }
+        if (!chunk)
+        {
+            if (!anyShadowed) continue;
+            auto air = std::make_unique<Chunk>();
+            chunk = air.get();
+            byY[cy] = chunk;
+            sections.emplace_back(cy, std::move(air));
+            lights[cy].assign(CHUNK_VOLUME, 0);
+        }
+        uint8_t* light = lights[cy].data();
+        hasCaves |= chunk->hasAirBelowSurface();
+
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            for (int x = 0; x < CHUNK_SIZE; x++)
+            {
+                bool& dark = shadowed[x + z * CHUNK_SIZE];
+                int height = chunk->getHeight(x, z);
+                if (dark)
+                {
+                    hasCaves |= height < CHUNK_SIZE - 1;
+                    continue;
+                }
+                for (int y = CHUNK_SIZE - 1; y > height; y--) light[lightIndex(x, y, z)] = FULL_SKY_LIGHT;
+                if (height >= 0)
+                {
+                    dark = true;
+                    anyShadowed = true;
+                }
+            }
+        }
+    }
+
+    ColumnLightAccess access(sections, byY.data(), lights, solidSections, sectionCount);
+    std::vector<LightNode> queue;
+    size_t touched = 0;
+
+    // 2- sunlight sideways into caves and under overhangs, from every lit cell next to dark air
+    if (hasCaves)
+    {
+        for (int cy = 0; cy < sectionCount; cy++)
+        {
+            if (!byY[cy]) continue;
+            const uint8_t* light = lights[cy].data();
+
+            for (int y = 0; y < CHUNK_SIZE; y++)
+            {
+                for (int z = 0; z < CHUNK_SIZE; z++)
+                {
+                    for (int x = 0; x < CHUNK_SIZE; x++)
+                    {
+                        if (light[lightIndex(x, y, z)] != FULL_SKY_LIGHT) continue;
+
+                        int worldY = cy * CHUNK_SIZE + y;
+                        for (int f = 0; f < 6; f++)
+                        {
+                            BlockID block;
+                            uint8_t neighborLight;
+                            if (!access.getCell(x + cubeFaceNormals[f][0], worldY + cubeFaceNormals[f][1], z + cubeFaceNormals[f][2], block, neighborLight)) continue;
+                            if (block == 0 && getSkyLight(neighborLight) < MAX_LIGHT - 1)
+                            {
+                                queue.push_back({ x, worldY, z });
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        touched += spreadLight(access, LightChannel::Sky, queue);
+    }
+
+    // 3- block light from every emitter, the palette says which sections have any
+    for (int cy = 0; cy < sectionCount; cy++)
+    {
+        Chunk* chunk = byY[cy];
+        if (!chunk || !chunk->containsBlock(GLOWSTONE)) continue;
+
+        for (int y = 0; y < CHUNK_SIZE; y++)
+        {
+            for (int z = 0; z < CHUNK_SIZE; z++)
+            {
+                for (int x = 0; x < CHUNK_SIZE; x++)
+                {
+                    int emission = getBlockEmission(chunk->getBlock(x, y, z));
+                    if (emission == 0) continue;
+                    uint8_t& light = lights[cy][lightIndex(x, y, z)];
+                    light = setChannelLight(light, LightChannel::Block, emission);
+                    queue.push_back({ x, cy * CHUNK_SIZE + y, z });
+                }
+            }
+        }
+    }
+    touched += spreadLight(access, LightChannel::Block, queue);
+
+    // packed once, every section ends up with a few light levels at most
+    for (int cy = 0; cy < sectionCount; cy++)
+    {
+        if (byY[cy]) byY[cy]->loadLight(lights[cy].data());
+    }
+    return touched;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Chunk.h"
+#include "CubeData.h"
+
+// flood fill lighting, sky and block light 0..15 per block (packed as in Chunk.h)
+// both channels lose 1 per step through air, sky light at 15 also runs straight down without losing any
+// solid blocks stop light, emitters (glowstone) are solid but hold their own emission as a source
+//
+// the fills work on an Access with
+//   bool getCell(int x, int y, int z, BlockID& block, uint8_t& light)  false = outside what can be lit
+//   void setLight(int x, int y, int z, uint8_t light)
+// so the same code lights a lone column on a worker and the loaded world on the main thread
+// both only ever visit cells whose light changes, an edit touches the region around it, not whole chunks
+
+enum class LightChannel
+{
+    Sky,
+    Block
+};
+
+struct LightNode
+{
+    int x, y, z;
+};
+
+// cell that lost its light, level = what it had before
+struct LightRemoval
+{
+    int x, y, z;
+    int level;
+};
+
+inline int getChannelLight(uint8_t light, LightChannel channel)
+{
+    return channel == LightChannel::Sky ? getSkyLight(light) : getBlockLight(light);
+}
+
+inline uint8_t setChannelLight(uint8_t light, LightChannel channel, int level)
+{
+    return channel == LightChannel::Sky ? (uint8_t)((light & 0x0F) | (level << 4)) : (uint8_t)((light & 0xF0) | level);
+}
+
+// spreads from the queued cells (their light already set) into darker air around them
+// empties the queue, returns the number of cells it lit
+template <typename Access>
+size_t spreadLight(Access& access, LightChannel channel, std::vector<LightNode>& queue)
+{
+    size_t touched = 0;
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        LightNode node = queue[head];
+        BlockID block;
+        uint8_t light;
+        if (!access.getCell(node.x, node.y, node.z, block, light)) continue;
+
+        int level = getChannelLight(light, channel);
+        if (level <= 1) continue;
+
+        for (int f = 0; f < 6; f++)
+        {
+            int nx = node.x + cubeFaceNormals[f][0];
+            int ny = node.y + cubeFaceNormals[f][1];
+            int nz = node.z + cubeFaceNormals[f][2];
+
+            BlockID neighborBlock;
+            uint8_t neighborLight;
+            if (!access.getCell(nx, ny, nz, neighborBlock, neighborLight) || neighborBlock != 0) continue;
+
+            bool sunColumn = channel == LightChannel::Sky && f == 5 && level == MAX_LIGHT;
+            int next = sunColumn ? MAX_LIGHT : level - 1;
+            if (getChannelLight(neighborLight, channel) >= next) continue;
+
+            access.setLight(nx, ny, nz, setChannelLight(neighborLight, channel, next));
+            queue.push_back({ nx, ny, nz });
+            touched++;
+        }
+    }
+    queue.clear();
+    return touched;
+}
+
+// darkens everything that got its light through the removed cells (already set to 0 by the caller)
+// lit cells at the edge of the dark region go into refill, spreading them afterwards fills the hole back in
+// empties removals, returns the number of cells it darkened
+template <typename Access>
+size_t removeLight(Access& access, LightChannel channel, std::vector<LightRemoval>& removals, std::vector<LightNode>& refill)
+{
+    size_t touched = 0;
+    for (size_t head = 0; head < removals.size(); head++)
+    {
+        LightRemoval node = removals[head];
+        for (int f = 0; f < 6; f++)
+        {
+            int nx = node.x + cubeFaceNormals[f][0];
+            int ny = node.y + cubeFaceNormals[f][1];
+            int nz = node.z + cubeFaceNormals[f][2];
+
+            BlockID neighborBlock;
+            uint8_t neighborLight;
+            if (!access.getCell(nx, ny, nz, neighborBlock, neighborLight)) continue;
+
+            int level = getChannelLight(neighborLight, channel);
+            if (level == 0) continue;
+
+            // dimmer than the removed cell (or under it in a sun column) = lit through it
+            bool sunColumn = channel == LightChannel::Sky && f == 5 && node.level == MAX_LIGHT && level == MAX_LIGHT;
+            int emission = channel == LightChannel::Block ? getBlockEmission(neighborBlock) : 0;
+            if ((level < node.level || sunColumn) && level > emission)
+            {
+                access.setLight(nx, ny, nz, setChannelLight(neighborLight, channel, emission));
+                removals.push_back({ nx, ny, nz, level });
+                touched++;
+            }
+            else refill.push_back({ nx, ny, nz });
+        }
+    }
+    removals.clear();
+    return touched;
+}
+
+// lights a freshly loaded column on its own, neighbour columns are blended in when it is added to the world
+// sections = the column's allocated sections (section y, chunk), solidSections / sectionCount as in VoxelWorld
+// sections missing above solidSections are air in full sky, those shadowed by blocks above get allocated here
+// safe to run on any thread, returns the number of cells the flood fills lit
+size_t lightColumn(std::vector<std::pair<int, std::unique_ptr<Chunk>>>& sections, int solidSections, int sectionCount);
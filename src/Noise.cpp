@@ -0,0 +1,218 @@
+#include "Noise.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// keeps single octave output at about -1..1
+static const float NOISE_SCALE = 0.7f;
+
+static const uint32_t HASH_X = 0x27d4eb2du;
+static const uint32_t HASH_Y = 0x165667b1u;
+static const uint32_t HASH_MIX = 0x2c1b3c6du;
+
+// octave o uses seed + o * OCTAVE_SEED_STEP so octaves dont line up at the origin
+static const uint32_t OCTAVE_SEED_STEP = 0x9e3779b9u;
+
+static uint32_t hashCell(int32_t x, int32_t y, uint32_t seed)
+{
+    uint32_t h = seed ^ ((uint32_t)x * HASH_X) ^ ((uint32_t)y * HASH_Y);
+    h ^= h >> 15;
+    h *= HASH_MIX;
+    h ^= h >> 12;
+    return h;
+}
+
+// dot of the offset with one of 8 gradients, (+-1, +-2) and (+-2, +-1) picked by the low 3 bits
+static float gradient(uint32_t h, float dx, float dy)
+{
+    float u = (h & 4) ? dy : dx;
+    float v = (h & 4) ? dx : dy;
+    return ((h & 1) ? -u : u) + ((h & 2) ? -(2.0f * v) : 2.0f * v);
+}
+
+static float fade(float t)
+{
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static float lerp(float a, float b, float t)
+{
+    return a + t * (b - a);
+}
+
+static float gradientNoise(float x, float y, uint32_t seed)
+{
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+    int32_t ix = (int32_t)fx;
+    int32_t iy = (int32_t)fy;
+    float dx = x - fx;
+    float dy = y - fy;
+
+    float n00 = gradient(hashCell(ix, iy, seed), dx, dy);
+    float n10 = gradient(hashCell(ix + 1, iy, seed), dx - 1.0f, dy);
+    float n01 = gradient(hashCell(ix, iy + 1, seed), dx, dy - 1.0f);
+    float n11 = gradient(hashCell(ix + 1, iy + 1, seed), dx - 1.0f, dy - 1.0f);
+
+    float u = fade(dx);
+    float v = fade(dy);
+    return lerp(lerp(n00, n10, u), lerp(n01, n11, u), v) * NOISE_SCALE;
+}
+
+// per octave frequency/amplitude, worked out once per call so both paths use the same floats
+struct Octave
+{
+    float frequency;
+    float amplitude;
+    uint32_t seed;
+};
+
+static int buildOctaves(const NoiseParams& params, Octave* octaves, float& normalize)
+{
+    int count = params.fractal == NoiseFractal::None ? 1 : params.octaves;
+    if (count < 1) count = 1;
+    if (count > 16) count = 16;
+
+    float frequency = params.frequency;
+    float amplitude = 1.0f;
+    float total = 0.0f;
+    for (int o = 0; o < count; o++)
+    {
+        octaves[o] = { frequency, amplitude, params.seed + (uint32_t)o * OCTAVE_SEED_STEP };
+        total += amplitude;
+        frequency *= params.lacunarity;
+        amplitude *= params.gain;
+    }
+    normalize = 1.0f / total;
+    return count;
+}
+
+static float fractalNoise(NoiseFractal fractal, const Octave* octaves, int count, float normalize, float x, float y)
+{
+    float sum = 0.0f;
+    for (int o = 0; o < count; o++)
+    {
+        float n = gradientNoise(x * octaves[o].frequency, y * octaves[o].frequency, octaves[o].seed);
+        if (fractal == NoiseFractal::Ridged)
+        {
+            n = 1.0f - std::fabs(n);
+            n = n * n;
+        }
+        sum = sum + n * octaves[o].amplitude;
+    }
+    return sum * normalize;
+}
+
+#if defined(__AVX2__)
+// the scalar functions above, 8 lanes at a time, keep the two in step when changing either
+
+static __m256i hashCell8(__m256i x, __m256i y, __m256i seed)
+{
+    __m256i h = _mm256_xor_si256(seed, _mm256_xor_si256(_mm256_mullo_epi32(x, _mm256_set1_epi32((int)HASH_X)),
+                                                         _mm256_mullo_epi32(y, _mm256_set1_epi32((int)HASH_Y))));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)HASH_MIX));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 12));
+    return h;
+}
+
+static __m256 gradient8(__m256i h, __m256 dx, __m256 dy)
+{
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(4)), _mm256_set1_epi32(4)));
+    __m256 u = _mm256_blendv_ps(dx, dy, swap);
+    __m256 v = _mm256_blendv_ps(dy, dx, swap);
+    v = _mm256_mul_ps(_mm256_set1_ps(2.0f), v);
+
+    // negation is a sign bit flip, bit 0 flips u and bit 1 flips v
+    __m256 signU = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+    __m256 signV = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+    return _mm256_add_ps(_mm256_xor_ps(u, signU), _mm256_xor_ps(v, signV));
+}
+
+static __m256 fade8(__m256 t)
+{
+    __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+}
+
+static __m256 lerp8(__m256 a, __m256 b, __m256 t)
+{
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+static __m256 gradientNoise8(__m256 x, __m256 y, uint32_t seed)
+{
+    __m256 fx = _mm256_floor_ps(x);
+    __m256 fy = _mm256_floor_ps(y);
+    __m256i ix = _mm256_cvttps_epi32(fx);
+    __m256i iy = _mm256_cvttps_epi32(fy);
+    __m256 dx = _mm256_sub_ps(x, fx);
+    __m256 dy = _mm256_sub_ps(y, fy);
+
+    __m256i seeds = _mm256_set1_epi32((int)seed);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i ix1 = _mm256_add_epi32(ix, one);
+    __m256i iy1 = _mm256_add_epi32(iy, one);
+    __m256 dx1 = _mm256_sub_ps(dx, _mm256_set1_ps(1.0f));
+    __m256 dy1 = _mm256_sub_ps(dy, _mm256_set1_ps(1.0f));
+
+    __m256 n00 = gradient8(hashCell8(ix, iy, seeds), dx, dy);
+    __m256 n10 = gradient8(hashCell8(ix1, iy, seeds), dx1, dy);
+    __m256 n01 = gradient8(hashCell8(ix, iy1, seeds), dx, dy1);
+    __m256 n11 = gradient8(hashCell8(ix1, iy1, seeds), dx1, dy1);
+
+    __m256 u = fade8(dx);
+    __m256 v = fade8(dy);
+    return _mm256_mul_ps(lerp8(lerp8(n00, n10, u), lerp8(n01, n11, u), v), _mm256_set1_ps(NOISE_SCALE));
+}
+
+static __m256 fractalNoise8(NoiseFractal fractal, const Octave* octaves, int count, float normalize, __m256 x, __m256 y)
+{
+    __m256 sum = _mm256_setzero_ps();
+    for (int o = 0; o < count; o++)
+    {
+        __m256 frequency = _mm256_set1_ps(octaves[o].frequency);
+        __m256 n = gradientNoise8(_mm256_mul_ps(x, frequency), _mm256_mul_ps(y, frequency), octaves[o].seed);
+        if (fractal == NoiseFractal::Ridged)
+        {
+            n = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_andnot_ps(_mm256_set1_ps(-0.0f), n));
+            n = _mm256_mul_ps(n, n);
+        }
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(n, _mm256_set1_ps(octaves[o].amplitude)));
+    }
+    return _mm256_mul_ps(sum, _mm256_set1_ps(normalize));
+}
+#endif
+
+void noise2(const NoiseParams& params, const float* x, const float* y, float* out, size_t count)
+{
+    Octave octaves[16];
+    float normalize;
+    int octaveCount = buildOctaves(params, octaves, normalize);
+
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 result = fractalNoise8(params.fractal, octaves, octaveCount, normalize, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i));
+        _mm256_storeu_ps(out + i, result);
+    }
+#endif
+    for (; i < count; i++) out[i] = fractalNoise(params.fractal, octaves, octaveCount, normalize, x[i], y[i]);
+}
+
+void fillNoiseGrid(const NoiseParams& params, int originX, int originY, int sizeX, int sizeY, float* out)
+{
+    std::vector<float> xs(sizeX);
+    std::vector<float> ys(sizeX);
+    for (int i = 0; i < sizeX; i++) xs[i] = (float)(originX + i);
+
+    for (int j = 0; j < sizeY; j++)
+    {
+        std::fill(ys.begin(), ys.end(), (float)(originY + j));
+        noise2(params, xs.data(), ys.data(), out + (size_t)j * sizeX, sizeX);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 2D gradient (perlin style) noise for terrain, replaces stb_perlin
+// lattice gradients come from an integer hash of the cell and seed instead of a permutation table,
+// so 8 samples are evaluated at once with AVX2 (built with VOXEL_AVX2) and one by one otherwise
+// both paths do the same float operations in the same order, a seed gives bit identical terrain on any cpu
+
+enum class NoiseFractal
+{
+    None,   // one octave, about -1..1
+    FBm,    // octaves summed with falling amplitude, about -1..1
+    Ridged  // octaves of (1 - |noise|)^2, sharp crests, 0..1
+};
+
+struct NoiseParams
+{
+    uint32_t seed = 0;
+    float frequency = 0.01f;
+    NoiseFractal fractal = NoiseFractal::None;
+    int octaves = 1;
+    float lacunarity = 2.0f; // frequency multiplier per octave
+    float gain = 0.5f;       // amplitude multiplier per octave
+};
+
+// one value per (x[i], y[i]), coordinates are scaled by params.frequency
+void noise2(const NoiseParams& params, const float* x, const float* y, float* out, size_t count);
+
+// sizeX * sizeY values on the integer grid from (originX, originY), out[i + j * sizeX] = sample at (originX + i, originY + j)
+// a chunk heightmap in one call, same values as noise2 at those coordinates
+void fillNoiseGrid(const NoiseParams& params, int originX, int originY, int sizeX, int sizeY, float* out);
@@ -29,7 +29,7 @@ void OutlineRenderer::init()
     glEnableVertexAttribArray(0);
 }
 
-void OutlineRenderer::render(Shader& shader, glm::vec3 pos, glm::mat4 view, glm::mat4 projection)
+void OutlineRenderer::render(Shader& shader, glm::vec3 pos, glm::mat4 view, glm::mat4 projection, glm::vec3 size)
 {
     glLineWidth(3.0f); 
     shader.use();
@@ -38,7 +38,7 @@ void OutlineRenderer::render(Shader& shader, glm::vec3 pos, glm::mat4 view, glm:
     
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, pos);
-    model = glm::scale(model, glm::vec3(1.002f));
+    model = glm::scale(model, size * 1.002f);
     model = glm::translate(model, glm::vec3(-0.001f)); 
 
     shader.setMat4("model", model);
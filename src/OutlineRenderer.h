@@ -12,7 +12,8 @@ public:
 
     void init(); // start
 
-    void render(Shader& shader, glm::vec3 pos, glm::mat4 view, glm::mat4 projection);
+    // box from pos to pos + size, a block by default
+    void render(Shader& shader, glm::vec3 pos, glm::mat4 view, glm::mat4 projection, glm::vec3 size = glm::vec3(1.0f));
 
 private:
     unsigned int VAO, VBO;
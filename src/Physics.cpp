@@ -1,158 +1,165 @@
 #include "Physics.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
+
+Physics::Physics()
+    : m_position(0.0f),
+      m_previousPosition(0.0f),
+      m_velocity(0.0f),
+      m_moveVelocity(0.0f),
+      m_jumpRequested(false),
+      m_onGround(false),
+      m_accumulator(0.0f),
+      m_tickCount(0)
+{
+}
 
-Physics::Physics() : m_verticalVelocity(0.0f) {}
-
-bool Physics::checkCollision(glm::vec3 pos, const VoxelWorld& world)
+float sweepBox(glm::vec3& boxMin, glm::vec3& boxMax, int axis, float distance, float skin, const VoxelWorld& world)
 {
-    float w = PLAYER_WIDTH;
-    
-    // check feet, waist and head
-    std::vector<glm::vec3> checkPoints = {
-        // feet
-        pos + glm::vec3(-w, 0.1f, -w), pos + glm::vec3( w, 0.1f, -w),
-        pos + glm::vec3(-w, 0.1f,  w), pos + glm::vec3( w, 0.1f,  w),
-        // waist
-        pos + glm::vec3(-w, 0.8f, -w), pos + glm::vec3( w, 0.8f, -w),
-        pos + glm::vec3(-w, 0.8f,  w), pos + glm::vec3( w, 0.8f,  w),
-        // head
-        pos + glm::vec3(-w, PLAYER_HEIGHT - 0.2f, -w), pos + glm::vec3( w, PLAYER_HEIGHT - 0.2f, -w),
-        pos + glm::vec3(-w, PLAYER_HEIGHT - 0.2f,  w), pos + glm::vec3( w, PLAYER_HEIGHT - 0.2f,  w)
-    };
-
-    for (const auto& p : checkPoints)
+    if (distance == 0.0f) return 0.0f;
+
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    // cells the box covers across the move, touching a cell edge doesnt count
+    int uFirst = (int)std::floor(boxMin[u]);
+    int uLast = (int)std::ceil(boxMax[u]) - 1;
+    int vFirst = (int)std::floor(boxMin[v]);
+    int vLast = (int)std::ceil(boxMax[v]) - 1;
+
+    // layers of cells the leading face enters, nearest first, cells the box already overlaps are skipped
+    bool positive = distance > 0.0f;
+    int first = positive ? (int)std::ceil(boxMax[axis]) : (int)std::floor(boxMin[axis]) - 1;
+    int last = positive ? (int)std::ceil(boxMax[axis] + distance) - 1 : (int)std::floor(boxMin[axis] + distance);
+    int step = positive ? 1 : -1;
+
+    float moved = distance;
+    for (int layer = first; positive ? layer <= last : layer >= last; layer += step)
     {
-        if (world.getBlock((int)floor(p.x), (int)floor(p.y), (int)floor(p.z)) > 0) return true;
+        bool blocked = false;
+        for (int a = uFirst; a <= uLast && !blocked; a++)
+        {
+            for (int b = vFirst; b <= vLast && !blocked; b++)
+            {
+                int cell[3];
+                cell[axis] = layer;
+                cell[u] = a;
+                cell[v] = b;
+                blocked = world.getBlock(cell[0], cell[1], cell[2]) > 0;
+            }
+        }
+        if (!blocked) continue;
+
+        // stop a skin short of the layer, never backwards
+        moved = positive ? std::max(0.0f, layer - boxMax[axis] - skin) : std::min(0.0f, (layer + 1) - boxMin[axis] + skin);
+        break;
     }
-    return false;
+
+    boxMin[axis] += moved;
+    boxMax[axis] += moved;
+    return moved;
 }
 
-void Physics::step(float deltaTime, VoxelWorld& world, Camera& camera)
+void Physics::tick(VoxelWorld& world, Camera& camera)
 {
-    if (camera.flying_mode) return;
+    m_tickCount++;
+    m_previousPosition = m_position;
+
+    m_velocity.x = m_moveVelocity.x;
+    m_velocity.z = m_moveVelocity.z;
+    if (m_jumpRequested && m_onGround) m_velocity.y = JUMP_FORCE;
+    m_jumpRequested = false;
 
     // gravity, hi newton!
-    m_verticalVelocity -= GRAVITY * deltaTime;
-    
-    // move
-    glm::vec3 nextPos = camera.Position;
-    nextPos.y += m_verticalVelocity * deltaTime;
-
-    // floor/ceiling collision
-    if (checkCollision(glm::vec3(nextPos.x, nextPos.y - PLAYER_HEIGHT, nextPos.z), world))
-    {
-        if (m_verticalVelocity < 0) m_verticalVelocity = 0; // landed
-        else if (m_verticalVelocity > 0) m_verticalVelocity = 0; // head hit, ouch
-    } 
-    else
+    m_velocity.y -= GRAVITY * FIXED_TIMESTEP;
+
+    // y first so landing is settled before sliding along walls, then x and z
+    glm::vec3 boxMin = m_position - glm::vec3(PLAYER_WIDTH, PLAYER_HEIGHT, PLAYER_WIDTH);
+    glm::vec3 boxMax = m_position + glm::vec3(PLAYER_WIDTH, HEAD_ROOM, PLAYER_WIDTH);
+    glm::vec3 delta = m_velocity * FIXED_TIMESTEP;
+
+    m_onGround = false;
+    const int axes[3] = { 1, 0, 2 };
+    for (int axis : axes)
     {
-        camera.Position = nextPos;
+        float moved = sweepBox(boxMin, boxMax, axis, delta[axis], SKIN, world);
+        if (moved == delta[axis]) continue;
+
+        if (axis == 1 && delta.y < 0.0f) m_onGround = true; // landed
+        m_velocity[axis] = 0.0f; // or head hit, ouch
     }
+    m_position = boxMin + glm::vec3(PLAYER_WIDTH, PLAYER_HEIGHT, PLAYER_WIDTH);
 
     // if falling from the world
-    if (camera.Position.y < -50)
+    if (m_position.y < -50)
     {
-        camera.Position = glm::vec3(16, 60, 16);
-        m_verticalVelocity = 0;
+        camera.Position = m_position;
+        respawn(world, camera);
     }
 }
 
-void Physics::move(glm::vec3 direction, float speed, VoxelWorld& world, Camera& camera)
+void Physics::step(float deltaTime, VoxelWorld& world, Camera& camera)
 {
-    if (camera.flying_mode) return;
-    if (glm::length(direction) == 0.0f) return;
-
-    // get velo
-    glm::vec3 moveStep = glm::normalize(direction) * speed;
-
-    glm::vec3 originalPos = camera.Position;
-
-    // x move
-    camera.Position.x += moveStep.x;
-    glm::vec3 feetPos = camera.Position; 
-    feetPos.y -= PLAYER_HEIGHT;
-    
-    if (checkCollision(feetPos, world))
+    if (camera.flying_mode)
     {
-        camera.Position.x = originalPos.x; // back x
+        // walking picks up from wherever the flying left the camera
+        m_position = m_previousPosition = camera.Position;
+        m_velocity = glm::vec3(0.0f);
+        m_accumulator = 0.0f;
+        return;
     }
 
-    // z move
-    camera.Position.z += moveStep.z;
-    feetPos = camera.Position; 
-    feetPos.y -= PLAYER_HEIGHT;
-    
-    if (checkCollision(feetPos, world))
+    m_accumulator += std::min(deltaTime, MAX_FRAME_TIME);
+    while (m_accumulator >= FIXED_TIMESTEP)
     {
-        camera.Position.z = originalPos.z; // back z
+        tick(world, camera);
+        m_accumulator -= FIXED_TIMESTEP;
     }
+
+    // render between the last two ticks, the leftover time says how far
+    camera.Position = glm::mix(m_previousPosition, m_position, getInterpolation());
+}
+
+float Physics::getGroundHeight(float x, float z, const VoxelWorld& world) const
+{
+    int height = world.getSurfaceHeight((int)floor(x), (int)floor(z));
+    if (height < 0) return -1.0f;
+    return (float)(height + 1);
 }
 
-void Physics::jump(VoxelWorld& world, Camera& camera)
+void Physics::respawn(const VoxelWorld& world, Camera& camera)
 {
-    if (camera.flying_mode) return;
+    m_velocity = glm::vec3(0.0f);
 
-    // jump if feets on ground
-    if (checkCollision(glm::vec3(camera.Position.x, camera.Position.y - PLAYER_HEIGHT - 0.1f, camera.Position.z), world))
+    float ground = getGroundHeight(camera.Position.x, camera.Position.z, world);
+    if (ground >= 0.0f)
+    {
+        camera.Position.y = ground + PLAYER_HEIGHT + SKIN;
+    }
+    else
     {
-        if (abs(m_verticalVelocity) < 0.1f) m_verticalVelocity = JUMP_FORCE;
+        camera.Position = SPAWN_POINT;
+        ground = getGroundHeight(SPAWN_POINT.x, SPAWN_POINT.z, world);
+        if (ground >= 0.0f) camera.Position.y = ground + PLAYER_HEIGHT + SKIN;
     }
+
+    // no interpolation across the jump
+    m_position = m_previousPosition = camera.Position;
 }
 
-RaycastResult Physics::raycast(glm::vec3 origin, glm::vec3 direction, float maxDist, const VoxelWorld& world)
+void Physics::move(glm::vec3 direction, float speed)
 {
-    int x = (int)floor(origin.x);
-    int y = (int)floor(origin.y);
-    int z = (int)floor(origin.z);
-
-    int stepX = (direction.x > 0) ? 1 : -1;
-    int stepY = (direction.y > 0) ? 1 : -1;
-    int stepZ = (direction.z > 0) ? 1 : -1;
-
-    float deltaDistX = (direction.x == 0) ? 1e30 : std::abs(1.0f / direction.x);
-    float deltaDistY = (direction.y == 0) ? 1e30 : std::abs(1.0f / direction.y);
-    float deltaDistZ = (direction.z == 0) ? 1e30 : std::abs(1.0f / direction.z);
-
-    float sideDistX = (direction.x < 0) ? (origin.x - x) * deltaDistX : (x + 1.0f - origin.x) * deltaDistX;
-    float sideDistY = (direction.y < 0) ? (origin.y - y) * deltaDistY : (y + 1.0f - origin.y) * deltaDistY;
-    float sideDistZ = (direction.z < 0) ? (origin.z - z) * deltaDistZ : (z + 1.0f - origin.z) * deltaDistZ;
-
-    int lastAxis = -1;
-    float dist = 0.0f;
-    
-    while (dist < maxDist)
-    {
-        if (sideDistX < sideDistY && sideDistX < sideDistZ)
-        {
-            sideDistX += deltaDistX;
-            x += stepX;
-            dist = sideDistX - deltaDistX;
-            lastAxis = 0;
-        }
-        else if (sideDistY < sideDistZ) 
-        {
-            sideDistY += deltaDistY;
-            y += stepY;
-            dist = sideDistY - deltaDistY;
-            lastAxis = 1;
-        }
-        else 
-        {
-            sideDistZ += deltaDistZ;
-            z += stepZ;
-            dist = sideDistZ - deltaDistZ;
-            lastAxis = 2;
-        }
+    direction.y = 0.0f;
+    m_moveVelocity = glm::length(direction) > 0.0f ? glm::normalize(direction) * speed : glm::vec3(0.0f);
+}
 
-        if (world.getBlock(x, y, z) > 0)
-        {
-            glm::vec3 normal(0.0f);
-            if (lastAxis == 0) normal.x = (float)-stepX;
-            if (lastAxis == 1) normal.y = (float)-stepY;
-            if (lastAxis == 2) normal.z = (float)-stepZ;
-            return { true, x, y, z, normal };
-        }
-    }
-    return { false, 0, 0, 0, glm::vec3(0.0f) };
-}
\ No newline at end of file
+void Physics::jump()
+{
+    m_jumpRequested = true;
+}
+
+RaycastResult Physics::raycast(glm::vec3 origin, glm::vec3 direction, float maxDist, const VoxelWorld& world) const
+{
+    return world.raycast(Ray{ origin, direction, maxDist });
+}
@@ -1,14 +1,13 @@
 #pragma once
 #include <glm/glm.hpp>
-#include <vector>
 #include "VoxelWorld.h"
 #include "Camera.h"
 
-struct RaycastResult {
-    bool hit;
-    int x, y, z;
-    glm::vec3 normal;
-};
+// moves the box along one axis by up to distance and returns how far it got, stopping skin short of solid blocks
+// only the cells the moving face sweeps over are read, so nothing is skipped at any speed
+// cells the box already overlaps dont block it, a block placed inside a body doesnt trap it
+// reads the world only, safe to run from several threads while nothing edits it
+float sweepBox(glm::vec3& boxMin, glm::vec3& boxMax, int axis, float distance, float skin, const VoxelWorld& world);
 
 class Physics
 {
@@ -16,25 +15,55 @@ public:
     // Constants
     const float GRAVITY = 18.0f;
     const float JUMP_FORCE = 8.0f;
-    const float PLAYER_HEIGHT = 1.7f;
-    const float PLAYER_WIDTH = 0.3f;
+    const float PLAYER_HEIGHT = 1.7f; // feet to eye
+    const float PLAYER_WIDTH = 0.3f;  // half width
+    // the box reaches this far over the eye, so the near plane never pokes into a ceiling
+    const float HEAD_ROOM = 0.1f;
+    // gap kept between the box and the blocks it stops against, so it never rests exactly on a cell edge
+    const float SKIN = 0.001f;
+
+    // the body moves in fixed ticks, the camera is interpolated between the last two
+    // same input, same result, at any frame rate
+    const float FIXED_TIMESTEP = 1.0f / 60.0f;
+    // a longer frame (a hitch, a breakpoint) only catches up this much instead of running hundreds of ticks
+    const float MAX_FRAME_TIME = 0.25f;
+    // respawn fallback when the player's own column isnt loaded, y is replaced by the ground height
+    const glm::vec3 SPAWN_POINT = glm::vec3(16.0f, 100.0f, 16.0f);
 
     Physics();
 
-    // update
+    // update, runs the ticks deltaTime adds up to and places the camera between the last two
+    // in ghost mode the body just follows the camera
     void step(float deltaTime, VoxelWorld& world, Camera& camera);
 
-    // horizontal move
-    void move(glm::vec3 direction, float speed, VoxelWorld& world, Camera& camera);
+    // horizontal move, speed in blocks per second, kept until the next call
+    void move(glm::vec3 direction, float speed);
+
+    // action, jumps on the next tick if the feet are on the ground then
+    void jump();
+
+    // ticks run so far, and how far (0..1) the camera is between the last two
+    uint64_t getTickCount() const { return m_tickCount; }
+    float getInterpolation() const { return m_accumulator / FIXED_TIMESTEP; }
+
+    // world y the feet rest on at x,z (top of the highest solid block), -1 when that column isnt loaded
+    float getGroundHeight(float x, float z, const VoxelWorld& world) const;
+    // stands the player on the surface at their x,z, or at the spawn column if that isnt loaded
+    void respawn(const VoxelWorld& world, Camera& camera);
 
-    // action
-    void jump(VoxelWorld& world, Camera& camera);
-    
-    RaycastResult raycast(glm::vec3 origin, glm::vec3 direction, float maxDist, const VoxelWorld& world);
+    // one ray through VoxelWorld::raycast
+    RaycastResult raycast(glm::vec3 origin, glm::vec3 direction, float maxDist, const VoxelWorld& world) const;
 
 private:
-    float m_verticalVelocity;
+    // eye position now and one tick ago
+    glm::vec3 m_position;
+    glm::vec3 m_previousPosition;
+    glm::vec3 m_velocity;
+    glm::vec3 m_moveVelocity;
+    bool m_jumpRequested;
+    bool m_onGround;
+    float m_accumulator;
+    uint64_t m_tickCount;
 
-    // aabb, funny name
-    bool checkCollision(glm::vec3 pos, const VoxelWorld& world);
+    void tick(VoxelWorld& world, Camera& camera);
 };
\ No newline at end of file
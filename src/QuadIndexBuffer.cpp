@@ -0,0 +1,41 @@
+#include "QuadIndexBuffer.h"
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+unsigned int QuadIndexBuffer::s_EBO = 0;
+size_t QuadIndexBuffer::s_quadCapacity = 0;
+
+unsigned int QuadIndexBuffer::get(size_t quadCount)
+{
+    if (s_EBO == 0) glGenBuffers(1, &s_EBO);
+
+    if (quadCount > s_quadCapacity)
+    {
+        // grow by doubling so a few large chunks dont rebuild it over and over
+        size_t capacity = s_quadCapacity > 0 ? s_quadCapacity : 4096;
+        while (capacity < quadCount) capacity *= 2;
+
+        std::vector<uint32_t> indices;
+        indices.reserve(capacity * 6);
+        for (size_t q = 0; q < capacity; q++)
+        {
+            uint32_t base = (uint32_t)(q * 4);
+            indices.push_back(base + 0);
+            indices.push_back(base + 1);
+            indices.push_back(base + 2);
+            indices.push_back(base + 2);
+            indices.push_back(base + 3);
+            indices.push_back(base + 0);
+        }
+
+        // element array binding is VAO state, upload through the copy target so the caller's VAO is untouched
+        glBindBuffer(GL_COPY_WRITE_BUFFER, s_EBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        s_quadCapacity = capacity;
+    }
+
+    return s_EBO;
+}
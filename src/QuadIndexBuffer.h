@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+// one element buffer shared by every chunk VAO
+// chunk meshes are 4 vertices per quad, indexed 0,1,2, 2,3,0 (+4 per quad)
+class QuadIndexBuffer
+{
+public:
+    // returns the buffer, grown (never shrunk) so it covers at least quadCount quads
+    // existing VAOs keep working after a grow since the buffer name stays the same
+    static unsigned int get(size_t quadCount);
+
+    static size_t getQuadCapacity() { return s_quadCapacity; }
+
+private:
+    static unsigned int s_EBO;
+    static size_t s_quadCapacity;
+};
@@ -0,0 +1,309 @@
+#include "RegionStore.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// file layout, all integers little endian
+//   0  "VXRG"
+//   4  version
+//   8  REGION_SIZE^2 slots of (offset, length, capacity), slot = local x + local z * REGION_SIZE
+//   .. payloads, each one sits in a capacity sized slot, the space between slots is free for the next save
+static const char REGION_MAGIC[4] = { 'V', 'X', 'R', 'G' };
+static const uint32_t REGION_VERSION = 1;
+static const size_t REGION_COLUMNS = REGION_SIZE * REGION_SIZE;
+static const size_t TABLE_OFFSET = 8;
+static const size_t ENTRY_BYTES = 12;
+static const size_t HEADER_BYTES = TABLE_OFFSET + REGION_COLUMNS * ENTRY_BYTES;
+// slots are rounded up to this, so a hole fits the same column again after a small edit
+static const size_t SLOT_ALIGN = 256;
+// open mappings kept around, streaming only ever touches a few regions at once
+static const size_t MAX_MAPPINGS = 64;
+
+static void put32(uint8_t* out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get32(const uint8_t* in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static ColumnCoord regionOf(ColumnCoord column)
+{
+    return { floorDiv(column.x, REGION_SIZE), floorDiv(column.z, REGION_SIZE) };
+}
+
+static size_t slotOf(ColumnCoord column)
+{
+    return floorMod(column.x, REGION_SIZE) + floorMod(column.z, REGION_SIZE) * REGION_SIZE;
+}
+
+// runs of (16 bit length, block), a whole chunk fits one run so uniform layers cost 3 bytes
+static void encodeRLE(const BlockID* blocks, size_t count, std::vector<uint8_t>& out)
+{
+    size_t i = 0;
+    while (i < count)
+    {
+        BlockID type = blocks[i];
+        size_t run = 1;
+        while (i + run < count && run < 0xFFFF && blocks[i + run] == type) run++;
+
+        out.push_back((uint8_t)run);
+        out.push_back((uint8_t)(run >> 8));
+        out.push_back(type);
+        i += run;
+    }
+}
+
+static bool decodeRLE(const uint8_t* data, size_t size, BlockID* out, size_t count)
+{
+    if (size % 3 != 0) return false;
+
+    size_t written = 0;
+    for (size_t i = 0; i < size; i += 3)
+    {
+        size_t run = (size_t)data[i] | ((size_t)data[i + 1] << 8);
+        if (run == 0 || written + run > count) return false;
+
+        std::memset(out + written, data[i + 2], run);
+        written += run;
+    }
+    return written == count;
+}
+
+// solid sections, section count, then per section (y, rle length, rle bytes)
+static void encodeColumn(const RegionStore::ColumnData& column, std::vector<uint8_t>& out)
+{
+    out.push_back((uint8_t)column.solidSections);
+    out.push_back((uint8_t)column.sections.size());
+
+    std::vector<BlockID> blocks(CHUNK_VOLUME);
+    for (const auto& [cy, chunk] : column.sections)
+    {
+        out.push_back((uint8_t)cy);
+        size_t lengthAt = out.size();
+        out.resize(out.size() + 4);
+
+        chunk->copyBlocks(blocks.data());
+        encodeRLE(blocks.data(), blocks.size(), out);
+        put32(&out[lengthAt], (uint32_t)(out.size() - lengthAt - 4));
+    }
+}
+
+RegionStore::RegionStore(std::string directory)
+    : m_directory(std::move(directory))
+{
+}
+
+std::string RegionStore::regionPath(ColumnCoord region) const
+{
+    return m_directory + "/r." + std::to_string(region.x) + "." + std::to_string(region.z) + ".vxr";
+}
+
+std::shared_ptr<MappedFile> RegionStore::getMapping(ColumnCoord region)
+{
+    std::lock_guard<std::mutex> lock(m_mappingMutex);
+
+    // a missing file is cached too (as null), fresh areas dont retry the open for every column
+    auto it = m_mappings.find(region);
+    if (it != m_mappings.end()) return it->second;
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(regionPath(region))) file.reset();
+
+    // readers still holding a dropped mapping keep it alive until they finish
+    if (m_mappings.size() >= MAX_MAPPINGS) m_mappings.clear();
+    m_mappings[region] = file;
+    return file;
+}
+
+void RegionStore::dropMapping(ColumnCoord region)
+{
+    std::lock_guard<std::mutex> lock(m_mappingMutex);
+    m_mappings.erase(region);
+}
+
+bool RegionStore::loadColumn(ColumnCoord coord, int& solidSections, std::vector<std::pair<int, std::unique_ptr<Chunk>>>& sections)
+{
+    if (!isEnabled()) return false;
+
+    std::shared_ptr<MappedFile> file = getMapping(regionOf(coord));
+    if (!file) return false;
+
+    const uint8_t* data = file->data();
+    size_t size = file->size();
+    if (size < HEADER_BYTES || std::memcmp(data, REGION_MAGIC, 4) != 0 || get32(data + 4) != REGION_VERSION) return false;
+
+    const uint8_t* entry = data + TABLE_OFFSET + slotOf(coord) * ENTRY_BYTES;
+    size_t offset = get32(entry);
+    size_t length = get32(entry + 4);
+    if (length == 0) return false; // never saved
+
+    auto damaged = [coord]()
+    {
+        std::cout << "region: column " << coord.x << "," << coord.z << " is damaged, regenerating it" << std::endl;
+        return false;
+    };
+
+    if (offset < HEADER_BYTES || offset + length > size || length < 2) return damaged();
+
+    const uint8_t* at = data + offset;
+    const uint8_t* end = at + length;
+    int solid = at[0];
+    int count = at[1];
+    at += 2;
+
+    std::vector<std::pair<int, std::unique_ptr<Chunk>>> loaded;
+    std::vector<BlockID> blocks(CHUNK_VOLUME);
+    for (int i = 0; i < count; i++)
+    {
+        if (end - at < 5) return damaged();
+        int cy = at[0];
+        size_t rleLength = get32(at + 1);
+        at += 5;
+
+        if (rleLength > (size_t)(end - at) || !decodeRLE(at, rleLength, blocks.data(), blocks.size())) return damaged();
+        at += rleLength;
+
+        auto chunk = std::make_unique<Chunk>();
+        chunk->loadBlocks(blocks.data());
+        loaded.emplace_back(cy, std::move(chunk));
+    }
+
+    solidSections = solid;
+    sections = std::move(loaded);
+    m_columnsLoaded++;
+    return true;
+}
+
+void RegionStore::saveColumns(const std::vector<ColumnData>& columns)
+{
+    if (!isEnabled() || columns.empty()) return;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    // one open and one table write per region file
+    std::unordered_map<ColumnCoord, std::vector<const ColumnData*>, ColumnCoordHash> byRegion;
+    for (const ColumnData& column : columns) byRegion[regionOf(column.coord)].push_back(&column);
+
+    for (const auto& [region, regionColumns] : byRegion) saveRegion(region, regionColumns);
+}
+
+void RegionStore::saveRegion(ColumnCoord region, const std::vector<const ColumnData*>& columns)
+{
+    std::string path = regionPath(region);
+
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file)
+    {
+        // new region, header with an empty table
+        std::vector<uint8_t> header(HEADER_BYTES, 0);
+        std::memcpy(header.data(), REGION_MAGIC, 4);
+        put32(&header[4], REGION_VERSION);
+
+        std::ofstream create(path, std::ios::binary);
+        create.write(reinterpret_cast<const char*>(header.data()), header.size());
+        create.close();
+
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file)
+        {
+            std::cout << "region: failed to open " << path << std::endl;
+            return;
+        }
+    }
+
+    uint8_t header[TABLE_OFFSET];
+    std::vector<uint8_t> table(REGION_COLUMNS * ENTRY_BYTES);
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    file.read(reinterpret_cast<char*>(table.data()), table.size());
+    if (!file || std::memcmp(header, REGION_MAGIC, 4) != 0 || get32(header + 4) != REGION_VERSION)
+    {
+        std::cout << "region: " << path << " is not a region file this build can write, skipping" << std::endl;
+        return;
+    }
+
+    file.seekg(0, std::ios::end);
+    size_t fileEnd = (size_t)file.tellg();
+
+    // (offset, capacity) of every slot the table on disk points at, sorted, nothing in them is overwritten
+    // so until the new table lands the old one still points at whole payloads
+    // a column's new payload goes to the first gap it fits, the slot it leaves is a gap for the next save
+    std::vector<std::pair<size_t, size_t>> taken;
+    for (size_t slot = 0; slot < REGION_COLUMNS; slot++)
+    {
+        const uint8_t* entry = &table[slot * ENTRY_BYTES];
+        if (get32(entry + 4) > 0) taken.emplace_back(get32(entry), get32(entry + 8));
+    }
+    std::sort(taken.begin(), taken.end());
+
+    auto allocate = [&](size_t capacity)
+    {
+        size_t at = HEADER_BYTES;
+        auto it = taken.begin();
+        for (; it != taken.end() && it->first < at + capacity; ++it) at = std::max(at, it->first + it->second);
+        taken.insert(it, { at, capacity });
+        return at;
+    };
+
+    // 1- payloads into free space
+    std::vector<uint8_t> payload;
+    for (const ColumnData* column : columns)
+    {
+        payload.clear();
+        encodeColumn(*column, payload);
+        size_t length = payload.size();
+        size_t capacity = (length + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+        payload.resize(capacity, 0);
+        size_t offset = allocate(capacity);
+        fileEnd = std::max(fileEnd, offset + capacity);
+
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+
+        uint8_t* entry = &table[slotOf(column->coord) * ENTRY_BYTES];
+        put32(entry, (uint32_t)offset);
+        put32(entry + 4, (uint32_t)length);
+        put32(entry + 8, (uint32_t)capacity);
+
+        m_columnsSaved++;
+        m_bytesWritten += payload.size();
+    }
+
+    // 2- the table, only once every payload it points at is out of our buffers
+    // (flush hands them to the OS, a crash of the game cant reorder them, a power cut still could)
+    file.flush();
+    file.seekp(TABLE_OFFSET);
+    file.write(reinterpret_cast<const char*>(table.data()), table.size());
+    file.close();
+    if (file.fail())
+    {
+        std::cout << "region: failed to write " << path << std::endl;
+        dropMapping(region);
+        return;
+    }
+
+    // 3- free space past the last slot the new table uses is cut off, so the file doesnt keep growing
+    // nothing reads there: readers only follow table entries, and the columns that moved arent loaded while saving
+    size_t usedEnd = HEADER_BYTES;
+    for (size_t slot = 0; slot < REGION_COLUMNS; slot++)
+    {
+        const uint8_t* entry = &table[slot * ENTRY_BYTES];
+        if (get32(entry + 4) > 0) usedEnd = std::max(usedEnd, (size_t)get32(entry) + get32(entry + 8));
+    }
+    if (usedEnd < fileEnd)
+    {
+        std::error_code error;
+        std::filesystem::resize_file(path, usedEnd, error);
+    }
+
+    // the next load maps the file again and sees the new table and payloads
+    dropMapping(region);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Chunk.h"
+#include "ChunkCoord.h"
+#include "MappedFile.h"
+
+// columns per region side, a region file holds REGION_SIZE * REGION_SIZE columns
+constexpr int REGION_SIZE = 16;
+
+// on disk world, one file per region of columns
+// file = header (magic, version) + offset table with one slot per column + column payloads
+// a payload is the column's solid section count plus each allocated section, RLE compressed
+// reads go through a memory mapping, so loading a column is a table lookup and a decompress
+// a column must never be loaded and saved at the same time, VoxelWorld only loads columns it doesnt hold
+class RegionStore
+{
+public:
+    // column ready to be written, chunk pointers must stay valid for the save call
+    struct ColumnData
+    {
+        ColumnCoord coord;
+        int solidSections = 0;
+        std::vector<std::pair<int, const Chunk*>> sections; // (section y, chunk)
+    };
+
+    // empty directory = persistence off, every load misses and saves do nothing
+    explicit RegionStore(std::string directory);
+
+    bool isEnabled() const { return !m_directory.empty(); }
+
+    // false if the column was never saved (or its payload is damaged), safe on any thread
+    bool loadColumn(ColumnCoord coord, int& solidSections, std::vector<std::pair<int, std::unique_ptr<Chunk>>>& sections);
+
+    // writes the columns grouped per region file, only the given slots are touched
+    // payloads go to space no table entry points at (a hole left by an earlier save, or the end of the file)
+    // and are flushed before the table that points at them, a save cut short leaves the old columns readable
+    void saveColumns(const std::vector<ColumnData>& columns);
+
+    // totals since startup, for the log
+    size_t getColumnsLoaded() const { return m_columnsLoaded; }
+    size_t getColumnsSaved() const { return m_columnsSaved; }
+    size_t getBytesWritten() const { return m_bytesWritten; }
+
+private:
+    std::string m_directory;
+
+    // mappings are shared so a reader keeps its view alive while a save swaps in a new one
+    std::mutex m_mappingMutex;
+    std::unordered_map<ColumnCoord, std::shared_ptr<MappedFile>, ColumnCoordHash> m_mappings;
+
+    std::atomic<size_t> m_columnsLoaded{0};
+    size_t m_columnsSaved = 0;
+    size_t m_bytesWritten = 0;
+
+    std::string regionPath(ColumnCoord region) const;
+    // mapping of the region file, null if the file doesnt exist yet
+    std::shared_ptr<MappedFile> getMapping(ColumnCoord region);
+    void dropMapping(ColumnCoord region);
+
+    void saveRegion(ColumnCoord region, const std::vector<const ColumnData*>& columns);
+};
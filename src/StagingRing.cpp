@@ -0,0 +1,116 @@
+#include "StagingRing.h"
+#include <glad/glad.h>
+#include <cstring>
+
+StagingRing::StagingRing(size_t capacity)
+    : m_capacity(capacity)
+{
+}
+
+StagingRing::~StagingRing()
+{
+    for (const FencedRange& range : m_fences) glDeleteSync((GLsync)range.sync);
+
+    if (m_buffer != 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+void StagingRing::init()
+{
+    // immutable storage, mapped once and kept mapped, coherent so no explicit flushes are needed
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, m_capacity, nullptr, flags);
+    m_mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, m_capacity, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+size_t StagingRing::write(const void* data, size_t size)
+{
+    if (size == 0 || size > m_capacity / 2) return INVALID;
+    if (m_buffer == 0) init();
+
+    // an unfenced batch must never lap the ring, a write adds at most 2 * size (skipped tail + data)
+    // fence what is there so the next writes can wait on it
+    if (m_batchBytes + 2 * size > m_capacity) fence();
+
+    // keep every write contiguous, skip the tail if it doesnt fit
+    // the skipped tail counts as written, so the write covers the wrapped range [m_head, capacity) + [0, end)
+    size_t begin = m_head;
+    size_t claimed = m_head;
+    if (begin + size > m_capacity)
+    {
+        m_batchBytes += m_capacity - begin;
+        begin = 0;
+    }
+    size_t end = begin + size;
+
+    waitForRange(claimed, end);
+
+    std::memcpy(m_mapped + begin, data, size);
+    m_head = end;
+    m_batchBytes += size;
+    return begin;
+}
+
+void StagingRing::fence()
+{
+    if (m_batchBytes == 0) return;
+
+    GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_fences.push_back({ m_batchBegin, m_head, sync });
+
+    m_batchBegin = m_head;
+    m_batchBytes = 0;
+}
+
+// [begin, end) with begin > end wraps, [begin, capacity) + [0, end)
+static bool rangesOverlap(size_t aBegin, size_t aEnd, size_t bBegin, size_t bEnd, size_t capacity)
+{
+    size_t a[2][2] = { { aBegin, aBegin <= aEnd ? aEnd : capacity }, { 0, aBegin <= aEnd ? 0 : aEnd } };
+    size_t b[2][2] = { { bBegin, bBegin <= bEnd ? bEnd : capacity }, { 0, bBegin <= bEnd ? 0 : bEnd } };
+    for (const auto& x : a)
+        for (const auto& y : b)
+            if (x[0] < x[1] && y[0] < y[1] && x[0] < y[1] && y[0] < x[1]) return true;
+    return false;
+}
+
+void StagingRing::waitForRange(size_t begin, size_t end)
+{
+    // the GPU passes fences in the order they were made, so blocking on the newest overlapping one covers all older ones
+    // a fence that doesnt overlap can still have newer ones behind it that do, every fence is checked
+    for (size_t i = m_fences.size(); i-- > 0;)
+    {
+        const FencedRange& range = m_fences[i];
+        if (!rangesOverlap(begin, end, range.begin, range.end, m_capacity)) continue;
+
+        GLenum status = glClientWaitSync((GLsync)range.sync, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) break;
+
+        m_fenceWaits++;
+        while (true)
+        {
+            status = glClientWaitSync((GLsync)range.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED) break;
+        }
+        break;
+    }
+
+    // retire everything the GPU already passed, oldest first
+    while (!m_fences.empty())
+    {
+        GLsync sync = (GLsync)m_fences.front().sync;
+        GLenum status = glClientWaitSync(sync, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+        glDeleteSync(sync);
+        m_fences.pop_front();
+    }
+}
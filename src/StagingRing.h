@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// upload staging, one immutable buffer mapped once for good (persistent + coherent)
+// data is memcpy'd in at the ring head and copied to its destination buffer on the GPU
+// written ranges are fenced per batch, a range is only reused once its fence has passed
+// GL thread only
+class StagingRing
+{
+public:
+    static constexpr size_t INVALID = SIZE_MAX;
+
+    explicit StagingRing(size_t capacity);
+    ~StagingRing();
+
+    StagingRing(const StagingRing&) = delete;
+    StagingRing& operator=(const StagingRing&) = delete;
+
+    // copies bytes into the ring and returns their offset in getBuffer()
+    // INVALID if size is more than half the ring, the caller uploads those some other way
+    size_t write(const void* data, size_t size);
+
+    // fences everything written since the last call, once per upload batch
+    void fence();
+
+    unsigned int getBuffer() const { return m_buffer; }
+    size_t getCapacity() const { return m_capacity; }
+
+    // times write() had to block on the GPU since startup
+    size_t getFenceWaits() const { return m_fenceWaits; }
+
+private:
+    struct FencedRange
+    {
+        size_t begin;
+        size_t end;
+        void* sync; // GLsync
+    };
+
+    size_t m_capacity;
+    unsigned int m_buffer = 0;
+    uint8_t* m_mapped = nullptr;
+
+    size_t m_head = 0;
+    size_t m_batchBegin = 0; // start of the writes not fenced yet
+    size_t m_batchBytes = 0;
+    std::deque<FencedRange> m_fences; // oldest first
+
+    size_t m_fenceWaits = 0;
+
+    void init();
+    // blocks until no fence overlapping [begin, end) is pending, then drops the fences the GPU already passed
+    // begin > end is a wrapped range
+    void waitForRange(size_t begin, size_t end);
+};
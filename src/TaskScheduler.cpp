@@ -0,0 +1,142 @@
+#include "TaskScheduler.h"
+
+// index of the pool worker running on this thread, -1 elsewhere
+static thread_local int t_workerIndex = -1;
+
+TaskScheduler::TaskScheduler(unsigned int threadCount)
+{
+    if (threadCount == 0)
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        m_workers.emplace_back(&TaskScheduler::workerLoop, this, (int)i);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    // queued work is dropped, running tasks finish
+    for (std::thread& worker : m_workers) worker.join();
+}
+
+void TaskScheduler::submit(std::function<void()> task, bool urgent)
+{
+    if (urgent)
+    {
+        std::lock_guard<std::mutex> lock(m_urgentMutex);
+        m_urgent.push_front(std::move(task));
+    }
+    else
+    {
+        // workers keep what they spawn, everyone else spreads it out
+        int target = t_workerIndex >= 0 ? t_workerIndex : (int)(m_nextQueue++ % m_queues.size());
+        WorkerQueue& queue = *m_queues[target];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queued++;
+    }
+    m_wake.notify_one();
+}
+
+bool TaskScheduler::tryRunOne(int self)
+{
+    std::function<void()> task;
+
+    // 1- urgent
+    {
+        std::lock_guard<std::mutex> lock(m_urgentMutex);
+        if (!m_urgent.empty())
+        {
+            task = std::move(m_urgent.front());
+            m_urgent.pop_front();
+        }
+    }
+
+    // 2- own deque, newest first
+    if (!task && self >= 0)
+    {
+        WorkerQueue& queue = *m_queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+
+    // 3- steal the oldest from the others
+    if (!task)
+    {
+        int count = (int)m_queues.size();
+        int start = self >= 0 ? self + 1 : 0;
+        for (int i = 0; i < count && !task; i++)
+        {
+            int victim = (start + i) % count;
+            if (victim == self) continue;
+
+            WorkerQueue& queue = *m_queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+    }
+
+    if (!task) return false;
+
+    m_queued--;
+    task();
+    return true;
+}
+
+void TaskScheduler::parallelFor(int count, const std::function<void(int)>& body)
+{
+    std::atomic<int> remaining(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        submit([&body, &remaining, i]()
+        {
+            body(i);
+            remaining--;
+        });
+    }
+
+    while (remaining > 0)
+    {
+        if (!tryRunOne(t_workerIndex)) std::this_thread::yield();
+    }
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    t_workerIndex = index;
+
+    while (!m_stopping)
+    {
+        if (tryRunOne(index)) continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this] { return m_stopping || m_queued > 0; });
+    }
+}
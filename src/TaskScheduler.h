@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// work stealing pool, every worker owns a deque
+// a worker pops its own newest task first (cache warm) and steals the oldest from others when idle
+// tasks must not touch GL, they run off the main thread
+class TaskScheduler
+{
+public:
+    // 0 = one worker per core, leaving one for the main thread
+    explicit TaskScheduler(unsigned int threadCount = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // urgent tasks skip every deque, used for block edits so they dont wait behind bulk work
+    void submit(std::function<void()> task, bool urgent = false);
+
+    // runs body(0..count-1) across the workers and blocks until all are done
+    // the calling thread helps out instead of sleeping
+    void parallelFor(int count, const std::function<void(int)>& body);
+
+    unsigned int getThreadCount() const { return (unsigned int)m_workers.size(); }
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+    std::mutex m_urgentMutex;
+    std::deque<std::function<void()>> m_urgent;
+
+    // sleeping workers wait on this, m_queued only changes upward under m_sleepMutex
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_queued{0};
+    std::atomic<bool> m_stopping{false};
+
+    // external submits are spread round robin
+    std::atomic<unsigned int> m_nextQueue{0};
+
+    // runs one task if it can find one, self = -1 for threads outside the pool
+    bool tryRunOne(int self);
+    void workerLoop(int index);
+};
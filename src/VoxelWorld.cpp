@@ -1,123 +1,1413 @@
 #include "VoxelWorld.h"
+#include "CubeData.h"
 #include <iostream>
 #include <cmath>
+#include <memory>
+#include <algorithm>
+#include <array>
+#include <tuple>
 
-VoxelWorld::VoxelWorld()
+// light of a section that isnt allocated, air is open to the sky (shadowed air gets allocated by lightColumn)
+static uint8_t implicitLight(BlockID block)
 {
-    m_chunks.resize(WORLD_SIZE * WORLD_SIZE);
-    generateTerrain();
+    return block == 0 ? FULL_SKY_LIGHT : 0;
 }
 
-void VoxelWorld::generateTerrain()
+// dda through the grid, t = distance along the ray where it entered the current cell
+struct RayWalk
 {
-    float frequency = 0.05f;
-    float amplitude = 10.0f;
-    int sea_level = 4;
+    int cell[3];
+    int step[3];
+    float delta[3]; // t between two boundaries on each axis
+    float rate[3];  // boundaries per t, 1 / delta
+    float side[3];  // t of the next boundary on each axis
+    float t;
+    int axis;       // axis of the last boundary crossed, -1 in the start cell
+};
 
-    std::cout << "generating " << WORLD_SIZE << "x" << WORLD_SIZE << " world..." << std::endl;
+// one cell forward, to the nearest boundary
+static void stepCell(RayWalk& walk)
+{
+    int a = (walk.side[0] < walk.side[1] && walk.side[0] < walk.side[2]) ? 0 : (walk.side[1] < walk.side[2] ? 1 : 2);
+    walk.t = walk.side[a];
+    walk.cell[a] += walk.step[a];
+    walk.side[a] += walk.delta[a];
+    walk.axis = a;
+}
+
+// steps out of the aligned 2^shift cube holding the current cell
+// the region is empty so the cells inside dont matter, only the exit cell and the axis it was entered through
+static void leaveRegion(RayWalk& walk, int shift)
+{
+    int mask = (1 << shift) - 1;
+    int crossings[3];
+    float exitT[3];
+    for (int a = 0; a < 3; a++)
+    {
+        // boundaries between the cell and the region edge ahead, the edge included
+        int offset = walk.cell[a] & mask;
+        crossings[a] = walk.step[a] > 0 ? mask + 1 - offset : offset + 1;
+        exitT[a] = walk.side[a] + (crossings[a] - 1) * walk.delta[a];
+    }
+    int exitAxis = (exitT[0] < exitT[1] && exitT[0] < exitT[2]) ? 0 : (exitT[1] < exitT[2] ? 1 : 2);
+    float t = exitT[exitAxis];
+
+    for (int a = 0; a < 3; a++)
+    {
+        int count = crossings[a];
+        if (a != exitAxis)
+        {
+            // the boundaries this axis passes before t, it stays inside the region
+            // a ray running exactly through an edge may go either way, both cells touch it
+            count = walk.side[a] < t ? (int)((t - walk.side[a]) * walk.rate[a]) + 1 : 0;
+            count = std::min(count, crossings[a] - 1);
+        }
+        walk.cell[a] += walk.step[a] * count;
+        walk.side[a] += walk.delta[a] * count;
+    }
+    walk.t = t;
+    walk.axis = exitAxis;
+}
+
+// the loaded world for the light fills, in world coords
+// unloaded columns and anything past the top or bottom are outside, light stops there
+// writing light into an implicit section allocates it, every change marks the meshes showing it
+class VoxelWorld::WorldLightAccess
+{
+public:
+    // the chunk constant, not VoxelWorld's setting of the same name
+    static constexpr int SIZE = ::CHUNK_SIZE;
+
+    explicit WorldLightAccess(VoxelWorld& world) : m_world(world) {}
 
-    for(int cx = 0; cx < WORLD_SIZE; cx++)
+    bool getCell(int x, int y, int z, BlockID& block, uint8_t& light)
     {
-        for(int cz = 0; cz < WORLD_SIZE; cz++) {
-            Chunk& currentChunk = m_chunks[cx + cz * WORLD_SIZE];
-            
-            for(int x = 0; x < CHUNK_SIZE; x++)
+        ChunkCoord coord{ floorDiv(x, SIZE), floorDiv(y, SIZE), floorDiv(z, SIZE) };
+        if (!lookup(coord)) return false;
+
+        if (m_chunk)
+        {
+            block = m_chunk->getBlock(floorMod(x, SIZE), floorMod(y, SIZE), floorMod(z, SIZE));
+            light = m_chunk->getLight(floorMod(x, SIZE), floorMod(y, SIZE), floorMod(z, SIZE));
+        }
+        else
+        {
+            block = m_world.implicitBlock(coord);
+            light = implicitLight(block);
+        }
+        return true;
+    }
+
+    void setLight(int x, int y, int z, uint8_t light)
+    {
+        ChunkCoord coord{ floorDiv(x, SIZE), floorDiv(y, SIZE), floorDiv(z, SIZE) };
+        if (!lookup(coord)) return;
+        if (!m_chunk) m_chunk = m_world.materializeChunk(coord);
+
+        int localX = floorMod(x, SIZE);
+        int localY = floorMod(y, SIZE);
+        int localZ = floorMod(z, SIZE);
+        m_chunk->setLight(localX, localY, localZ, light);
+        m_world.markLightDirty(coord, localX, localY, localZ);
+    }
+
+private:
+    // false when coord is outside, m_chunk = nullptr for an implicit section
+    // the fills stay in one section most of the time, so the last one is remembered
+    bool lookup(ChunkCoord coord)
+    {
+        if (m_hasLast && coord == m_lastCoord) return m_lastInside;
+
+        m_hasLast = true;
+        m_lastCoord = coord;
+        m_chunk = m_world.findChunk(coord);
+        m_lastInside = coord.y >= 0 && coord.y < m_world.WORLD_SECTIONS && m_world.findColumn({ coord.x, coord.z });
+        return m_lastInside;
+    }
+
+    VoxelWorld& m_world;
+    bool m_hasLast = false;
+    bool m_lastInside = false;
+    ChunkCoord m_lastCoord{ 0, 0, 0 };
+    Chunk* m_chunk = nullptr;
+};
+
+VoxelWorld::VoxelWorld(unsigned int workerThreads, const std::string& saveDirectory)
+    : m_regions(saveDirectory), m_scheduler(workerThreads)
+{
+}
+
+void VoxelWorld::terrainHeights(int worldX, int worldZ, int size, int* out) const
+{
+    // broad fbm hills plus small bumps, tall enough to span several sections
+    NoiseParams hills;
+    hills.seed = seed;
+    hills.frequency = 0.01f;
+    hills.fractal = NoiseFractal::FBm;
+    hills.octaves = 3;
+    float amplitude = 64.0f;
+
+    NoiseParams detail;
+    detail.seed = seed + 1;
+    detail.frequency = 0.05f;
+    float detail_amplitude = 8.0f;
+    int sea_level = 20;
+
+    // whole grid per call, the noise runs 8 columns at a time with AVX2
+    std::vector<float> hillValues(size * size);
+    std::vector<float> detailValues(size * size);
+    fillNoiseGrid(hills, worldX, worldZ, size, size, hillValues.data());
+    fillNoiseGrid(detail, worldX, worldZ, size, size, detailValues.data());
+
+    int top = WORLD_SECTIONS * CHUNK_SIZE - 1;
+    for (int i = 0; i < size * size; i++)
+    {
+        int height = sea_level + (int)((hillValues[i] + 1.0f) * 0.5f * amplitude) + (int)(detailValues[i] * detail_amplitude);
+        if (height > top) height = top;
+        if (height < 0) height = 0;
+        out[i] = height;
+    }
+}
+
+void VoxelWorld::generateColumn(ColumnCoord coord, GeneratedColumn& out) const
+{
+    out.coord = coord;
+
+    // heights with a 1 block ring from the neighbour columns
+    const int ring = CHUNK_SIZE + 2;
+    std::vector<int> heights(ring * ring);
+    terrainHeights(coord.x * CHUNK_SIZE - 1, coord.z * CHUNK_SIZE - 1, ring, heights.data());
+
+    int minHeight = WORLD_SECTIONS * CHUNK_SIZE;
+    int maxHeight = 0;
+    for (int z = -1; z <= CHUNK_SIZE; z++)
+    {
+        for (int x = -1; x <= CHUNK_SIZE; x++)
+        {
+            int height = heights[(x + 1) + (z + 1) * ring];
+
+            minHeight = std::min(minHeight, height);
+            bool inside = x >= 0 && x < CHUNK_SIZE && z >= 0 && z < CHUNK_SIZE;
+            if (inside) maxHeight = std::max(maxHeight, height);
+        }
+    }
+
+    // sections entirely below (lowest height incl. the ring - 3) are pure stone with solid blocks
+    // above and beside them, nothing in there can be seen so they stay implicit
+    out.column.solidSections = minHeight >= 2 ? (minHeight - 2) / CHUNK_SIZE : 0;
+    int topSection = maxHeight / CHUNK_SIZE; // everything above is air
+
+    // fill a plain array and hand it over once, the palette gets built in one pass
+    std::vector<BlockID> blocks(CHUNK_VOLUME);
+    for (int cy = out.column.solidSections; cy <= topSection; cy++)
+    {
+        std::fill(blocks.begin(), blocks.end(), 0);
+        int baseY = cy * CHUNK_SIZE;
+
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            for (int z = 0; z < CHUNK_SIZE; z++)
             {
-                for(int z = 0; z < CHUNK_SIZE; z++)
-                {
-                    int worldX = (cx * CHUNK_SIZE) + x;
-                    int worldZ = (cz * CHUNK_SIZE) + z;
+                int height = heights[(x + 1) + (z + 1) * ring];
+
+                for (int y = baseY; y <= height && y < baseY + CHUNK_SIZE; y++) {
+                    BlockID type;
+                    if (y == height) type = 1;
+                    else if (y > height - 3) type = 2;
+                    else type = 3;
+                    blocks[x + (z * CHUNK_SIZE) + ((y - baseY) * CHUNK_SIZE * CHUNK_SIZE)] = type;
+                }
+            }
+        }
+
+        auto chunk = std::make_unique<Chunk>();
+        chunk->loadBlocks(blocks.data());
+        out.sections.emplace_back(cy, std::move(chunk));
+    }
+}
+
+void VoxelWorld::loadColumn(ColumnCoord coord, GeneratedColumn& out)
+{
+    out.coord = coord;
+    out.fromDisk = m_regions.loadColumn(coord, out.column.solidSections, out.sections);
+    if (!out.fromDisk) generateColumn(coord, out);
+
+    // light isnt saved, it is worked out again here on the worker
+    lightColumn(out.sections, out.column.solidSections, WORLD_SECTIONS);
+}
+
+void VoxelWorld::saveColumns(const std::vector<ColumnCoord>& columns)
+{
+    std::vector<RegionStore::ColumnData> data;
+    data.reserve(columns.size());
+    for (const ColumnCoord& coord : columns)
+    {
+        const ChunkColumn* column = findColumn(coord);
+        if (!column) continue;
+
+        RegionStore::ColumnData& saved = data.emplace_back();
+        saved.coord = coord;
+        saved.solidSections = column->solidSections;
+        for (int cy = 0; cy < WORLD_SECTIONS; cy++)
+        {
+            if (const Chunk* chunk = findChunk({ coord.x, cy, coord.z })) saved.sections.emplace_back(cy, chunk);
+        }
+    }
+    m_regions.saveColumns(data);
+}
+
+void VoxelWorld::saveUnloadedColumns(const std::vector<UnloadedColumn>& columns)
+{
+    std::vector<RegionStore::ColumnData> data;
+    data.reserve(columns.size());
+    for (const UnloadedColumn& column : columns)
+    {
+        RegionStore::ColumnData& saved = data.emplace_back();
+        saved.coord = column.coord;
+        saved.solidSections = column.solidSections;
+        for (const auto& [cy, chunk] : column.sections) saved.sections.emplace_back(cy, chunk.get());
+    }
+    m_regions.saveColumns(data);
+}
+
+void VoxelWorld::flushUnloadedColumns()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_savedMutex);
+        for (const ColumnCoord& coord : m_savedColumns) m_savingColumns.erase(coord);
+        m_savedColumns.clear();
+        if (m_saveInFlight || m_saveQueue.empty()) return;
+        m_saveInFlight = true;
+    }
+
+    // urgent: it is a single task, and the columns it holds cant be loaded again until it is done
+    // the chunks are freed on the worker with the batch, their mesh space was already given back
+    auto batch = std::make_shared<std::vector<UnloadedColumn>>(std::move(m_saveQueue));
+    m_saveQueue.clear();
+    m_scheduler.submit([this, batch]()
+    {
+        saveUnloadedColumns(*batch);
+        {
+            std::lock_guard<std::mutex> lock(m_savedMutex);
+            for (const UnloadedColumn& column : *batch) m_savedColumns.push_back(column.coord);
+            m_saveInFlight = false;
+        }
+        m_saveDone.notify_all();
+    }, true);
+}
+
+void VoxelWorld::save()
+{
+    if (!m_regions.isEnabled()) return;
+
+    // the save task is the only writer, let it finish, whatever unloaded after it is written here with the rest
+    {
+        std::unique_lock<std::mutex> lock(m_savedMutex);
+        m_saveDone.wait(lock, [this] { return !m_saveInFlight; });
+    }
+    if (m_dirtyColumns.empty() && m_saveQueue.empty()) return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t bytesBefore = m_regions.getBytesWritten();
+
+    std::vector<ColumnCoord> dirty(m_dirtyColumns.begin(), m_dirtyColumns.end());
+    saveColumns(dirty);
+    saveUnloadedColumns(m_saveQueue);
+    size_t saved = dirty.size() + m_saveQueue.size();
+    m_dirtyColumns.clear();
+    m_saveQueue.clear();
+    m_savingColumns.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_savedMutex);
+        m_savedColumns.clear();
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    std::cout << "saved " << saved << " columns, " << (m_regions.getBytesWritten() - bytesBefore) / 1024
+              << " KiB in " << elapsed.count() << " ms" << std::endl;
+}
+
+void VoxelWorld::generateAround(glm::vec3 center)
+{
+    ColumnCoord centerCoord{ floorDiv((int)std::floor(center.x), CHUNK_SIZE), floorDiv((int)std::floor(center.z), CHUNK_SIZE) };
+
+    std::vector<ColumnCoord> missing;
+    for (int dx = -loadRadius; dx <= loadRadius; dx++)
+    {
+        for (int dz = -loadRadius; dz <= loadRadius; dz++)
+        {
+            if (dx * dx + dz * dz > loadRadius * loadRadius) continue;
+
+            ColumnCoord coord{ centerCoord.x + dx, centerCoord.z + dz };
+            if (!findColumn(coord) && !m_pendingGeneration.count(coord)) missing.push_back(coord);
+        }
+    }
+
+    std::cout << "loading " << missing.size() << " columns around the player..." << std::endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // one task per column, a column only depends on its own coords so the result is the same on any thread count
+    std::vector<GeneratedColumn> columns(missing.size());
+    m_scheduler.parallelFor((int)missing.size(), [this, &missing, &columns](int index)
+    {
+        loadColumn(missing[index], columns[index]);
+    });
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    size_t sections = 0;
+    size_t blockBytes = 0;
+    size_t lightBytes = 0;
+    size_t fromDisk = 0;
+    for (const GeneratedColumn& column : columns)
+    {
+        fromDisk += column.fromDisk;
+        sections += column.sections.size();
+        for (const auto& [cy, chunk] : column.sections)
+        {
+            blockBytes += chunk->getBlockMemoryUsage();
+            lightBytes += chunk->getLightMemoryUsage();
+        }
+    }
+
+    std::cout << "load complete! " << missing.size() << " columns (" << fromDisk << " from disk, "
+              << missing.size() - fromDisk << " generated), "
+              << sections << "/" << missing.size() * WORLD_SECTIONS << " sections allocated, in " << elapsed.count() << " ms"
+              << " (" << m_scheduler.getThreadCount() << " workers + main)" << std::endl;
+    if (elapsed.count() > 0.0)
+    {
+        double seconds = elapsed.count() / 1000.0;
+        std::cout << "throughput: " << (int)(missing.size() / seconds) << " columns/s, "
+                  << (int)(sections / seconds) << " chunks/s" << std::endl;
+    }
+    // plain = a byte per block and a byte of light per block
+    std::cout << "block storage: " << blockBytes / 1024 << " KiB blocks + " << lightBytes / 1024 << " KiB light palette packed vs "
+              << sections * CHUNK_VOLUME * 2 / 1024 << " KiB as plain arrays" << std::endl;
+
+    m_lodCenter = centerCoord;
+    m_rebuildStart = std::chrono::high_resolution_clock::now();
+    m_reportRebuild = true;
+    for (GeneratedColumn& column : columns)
+    {
+        insertColumn(column);
+    }
+    requestInsertedColumnMeshes();
+
+    // a blocking load, the copies are done here instead of holding up the first edits
+    waitForSnapshots({ centerCoord.x - loadRadius, 0, centerCoord.z - loadRadius },
+                     { centerCoord.x + loadRadius, WORLD_SECTIONS - 1, centerCoord.z + loadRadius });
+}
+
+void VoxelWorld::setMeshMode(MeshMode mode)
+{
+    if (mode == m_meshMode) return;
+    m_meshMode = mode;
+    rebuildAllMeshes();
+}
+
+void VoxelWorld::setAmbientOcclusion(bool enabled)
+{
+    if (enabled == m_ambientOcclusion) return;
+    m_ambientOcclusion = enabled;
+    rebuildAllMeshes();
+}
+
+void VoxelWorld::rebuildAllMeshes()
+{
+    m_rebuildStart = std::chrono::high_resolution_clock::now();
+    m_reportRebuild = true;
+
+    for (const auto& [coord, column] : m_columns)
+    {
+        if (hasAllNeighbors(coord)) requestColumnMeshes(coord);
+    }
+}
+
+Chunk* VoxelWorld::findChunk(ChunkCoord coord) const
+{
+    auto it = m_chunks.find(coord);
+    return it != m_chunks.end() ? it->second.get() : nullptr;
+}
+
+std::vector<ChunkCoord> VoxelWorld::getChunkCoords() const
+{
+    std::vector<ChunkCoord> coords;
+    coords.reserve(m_chunks.size());
+    for (const auto& [coord, chunk] : m_chunks) coords.push_back(coord);
+    return coords;
+}
+
+void VoxelWorld::copyPadded(ChunkCoord coord, PaddedBlocks& padded) const
+{
+    SnapshotSources sources;
+    gatherSnapshotSources(coord, sources);
+    buildPaddedBlocks(sources, padded);
+}
+
+const VoxelWorld::ChunkColumn* VoxelWorld::findColumn(ColumnCoord coord) const
+{
+    auto it = m_columns.find(coord);
+    return it != m_columns.end() ? &it->second : nullptr;
+}
+
+BlockID VoxelWorld::implicitBlock(ChunkCoord coord) const
+{
+    // nothing is ever seen from below the world, treat it as solid so y=0 bottoms get culled
+    if (coord.y < 0) return 3;
+    if (coord.y >= WORLD_SECTIONS) return 0;
+
+    const ChunkColumn* column = findColumn({ coord.x, coord.z });
+    if (!column) return 0; // not loaded yet, treat as air
+
+    return coord.y < column->solidSections ? 3 : 0;
+}
+
+Chunk* VoxelWorld::materializeChunk(ChunkCoord coord)
+{
+    if (Chunk* chunk = findChunk(coord)) return chunk;
+    if (coord.y < 0 || coord.y >= WORLD_SECTIONS) return nullptr;
+    if (!findColumn({ coord.x, coord.z })) return nullptr;
+
+    auto chunk = std::make_unique<Chunk>();
+    chunk->fill(implicitBlock(coord));
+    chunk->fillLight(implicitLight(implicitBlock(coord)));
+
+    Chunk* raw = chunk.get();
+    m_chunks[coord] = std::move(chunk);
+    return raw;
+}
+
+bool VoxelWorld::hasAllNeighbors(ColumnCoord coord) const
+{
+    return findColumn({ coord.x - 1, coord.z }) && findColumn({ coord.x + 1, coord.z }) &&
+           findColumn({ coord.x, coord.z - 1 }) && findColumn({ coord.x, coord.z + 1 });
+}
+
+void VoxelWorld::requestColumnMeshes(ColumnCoord coord)
+{
+    for (int cy = 0; cy < WORLD_SECTIONS; cy++)
+    {
+        ChunkCoord section{ coord.x, cy, coord.z };
+        if (findChunk(section)) requestMesh(section);
+    }
+}
+
+void VoxelWorld::insertColumn(GeneratedColumn& generated)
+{
+    ColumnCoord coord = generated.coord;
+    // light is blended into the 4 neighbours
+    waitForSnapshots({ coord.x - 1, 0, coord.z - 1 }, { coord.x + 1, WORLD_SECTIONS - 1, coord.z + 1 });
+    m_columns[coord] = generated.column;
+    m_columns[coord].lod = lodForColumn(coord);
+    if (!generated.fromDisk) m_dirtyColumns.insert(coord);
+    m_insertedColumns++;
+    m_insertedChunks += generated.sections.size();
+    for (auto& [cy, chunk] : generated.sections)
+    {
+        m_chunks[{ coord.x, cy, coord.z }] = std::move(chunk);
+    }
+    blendColumnLight(coord);
+
+    // a column is meshed once all 4 neighbours are in, so its borders are culled right the first time
+    const ColumnCoord around[5] = {
+        coord,
+        { coord.x - 1, coord.z }, { coord.x + 1, coord.z },
+        { coord.x, coord.z - 1 }, { coord.x, coord.z + 1 }
+    };
+    for (const ColumnCoord& c : around)
+    {
+        if (findColumn(c) && hasAllNeighbors(c)) m_columnsToMesh.insert(c);
+    }
+}
+
+void VoxelWorld::requestInsertedColumnMeshes()
+{
+    // after all inserts, a copy started between two of them would hold up the next one's light blending
+    for (const ColumnCoord& coord : m_columnsToMesh)
+    {
+        if (findColumn(coord) && hasAllNeighbors(coord)) requestColumnMeshes(coord);
+    }
+    m_columnsToMesh.clear();
+}
+
+void VoxelWorld::update(glm::vec3 playerPos)
+{
+    ColumnCoord center{ floorDiv((int)std::floor(playerPos.x), CHUNK_SIZE), floorDiv((int)std::floor(playerPos.z), CHUNK_SIZE) };
+
+    if (!(center == m_lodCenter)) updateColumnLods(center);
+    streamColumns(center);
+    requestLodRemeshes();
+    remeshDirtyChunks();
+    uploadCompletedMeshes();
+}
+
+void VoxelWorld::streamColumns(ColumnCoord center)
+{
+    auto distanceSq = [center](ColumnCoord c)
+    {
+        return (c.x - center.x) * (c.x - center.x) + (c.z - center.z) * (c.z - center.z);
+    };
+
+    // 1- take in what the workers generated
+    std::vector<GeneratedColumn> generated;
+    {
+        std::lock_guard<std::mutex> lock(m_generatedMutex);
+        generated.swap(m_generatedColumns);
+    }
+    for (GeneratedColumn& g : generated)
+    {
+        m_pendingGeneration.erase(g.coord);
+        // player moved on while it was being built
+        if (distanceSq(g.coord) > unloadRadius * unloadRadius) continue;
+        insertColumn(g);
+    }
+
+    // 2- drop what is past the unload radius, GL buffers go with the chunks
+    // changed columns hand their chunks to the save queue instead, they are written on a worker
+    std::vector<ColumnCoord> unloading;
+    for (const auto& [coord, column] : m_columns)
+    {
+        if (distanceSq(coord) > unloadRadius * unloadRadius) unloading.push_back(coord);
+    }
+
+    for (const ColumnCoord& coord : unloading)
+    {
+        waitForSnapshots({ coord.x, 0, coord.z }, { coord.x, WORLD_SECTIONS - 1, coord.z });
+        bool keep = m_dirtyColumns.erase(coord) && m_regions.isEnabled();
+        UnloadedColumn unloaded;
+        unloaded.coord = coord;
+        unloaded.solidSections = m_columns[coord].solidSections;
+        for (int cy = 0; cy < WORLD_SECTIONS; cy++)
+        {
+            auto it = m_chunks.find({ coord.x, cy, coord.z });
+            if (it == m_chunks.end()) continue;
+            if (keep)
+            {
+                it->second->releaseMesh();
+                unloaded.sections.emplace_back(cy, std::move(it->second));
+            }
+            m_chunks.erase(it);
+        }
+        m_columns.erase(coord);
+
+        if (keep)
+        {
+            m_savingColumns.insert(coord);
+            m_saveQueue.push_back(std::move(unloaded));
+        }
+    }
+    flushUnloadedColumns();
+    requestInsertedColumnMeshes();
+
+    // 3- queue the nearest missing columns, capped so the pool stays free for meshing
+    if (m_loadOffsetsRadius != loadRadius)
+    {
+        m_loadOffsets.clear();
+        for (int dx = -loadRadius; dx <= loadRadius; dx++)
+        {
+            for (int dz = -loadRadius; dz <= loadRadius; dz++)
+            {
+                if (dx * dx + dz * dz <= loadRadius * loadRadius) m_loadOffsets.push_back({ dx, dz });
+            }
+        }
+        std::sort(m_loadOffsets.begin(), m_loadOffsets.end(), [](ColumnCoord a, ColumnCoord b)
+        {
+            return a.x * a.x + a.z * a.z < b.x * b.x + b.z * b.z;
+        });
+        m_loadOffsetsRadius = loadRadius;
+    }
+
+    size_t maxInFlight = m_scheduler.getThreadCount() * 2;
+    for (const ColumnCoord& offset : m_loadOffsets)
+    {
+        if (m_pendingGeneration.size() >= maxInFlight) break;
+
+        ColumnCoord coord{ center.x + offset.x, center.z + offset.z };
+        // a column still being saved comes back once its save is on disk, not from older data
+        if (findColumn(coord) || m_pendingGeneration.count(coord) || m_savingColumns.count(coord)) continue;
+
+        m_pendingGeneration.insert(coord);
+        m_scheduler.submit([this, coord]()
+        {
+            GeneratedColumn column;
+            loadColumn(coord, column);
+
+            std::lock_guard<std::mutex> lock(m_generatedMutex);
+            m_generatedColumns.push_back(std::move(column));
+        });
+    }
+}
+
+int VoxelWorld::lodForColumn(ColumnCoord coord, int current) const
+{
+    int dx = coord.x - m_lodCenter.x;
+    int dz = coord.z - m_lodCenter.z;
+    int distanceSq = dx * dx + dz * dz;
+
+    int lod = 0;
+    while (lod < LOD_LEVELS - 1 && distanceSq >= lodDistances[lod] * lodDistances[lod]) lod++;
+    if (current < 0 || lod == current) return lod;
 
-                    float noise_value = stb_perlin_noise3(worldX * frequency, worldZ * frequency, 0.0f, 0, 0, 0);
-                    int height = sea_level + (int)((noise_value + 1.0f) * 0.5f * amplitude);
+    // the current band widened by lodHysteresis on both sides
+    int inner = current > 0 ? std::max(lodDistances[current - 1] - lodHysteresis, 0) : 0;
+    bool keep = distanceSq >= inner * inner;
+    if (current < LOD_LEVELS - 1)
+    {
+        int outer = lodDistances[current] + lodHysteresis;
+        keep = keep && distanceSq < outer * outer;
+    }
+    return keep ? current : lod;
+}
+
+void VoxelWorld::updateColumnLods(ColumnCoord center)
+{
+    m_lodCenter = center;
+
+    // only the rings crossing a band edge change, the rest keep their meshes
+    // their neighbours are remeshed too, skirts depend on the level next door
+    std::unordered_set<ColumnCoord, ColumnCoordHash> remesh;
+    for (auto& [coord, column] : m_columns)
+    {
+        int lod = lodForColumn(coord, column.lod);
+        if (lod == column.lod) continue;
+
+        column.lod = lod;
+        remesh.insert(coord);
+        remesh.insert({ coord.x - 1, coord.z });
+        remesh.insert({ coord.x + 1, coord.z });
+        remesh.insert({ coord.x, coord.z - 1 });
+        remesh.insert({ coord.x, coord.z + 1 });
+    }
+
+    // a column keeps drawing its old mesh until the queue gets to it
+    std::vector<ColumnCoord> queued;
+    for (const ColumnCoord& coord : remesh)
+    {
+        if (findColumn(coord) && m_lodRemeshQueued.insert(coord).second) queued.push_back(coord);
+    }
+    std::sort(queued.begin(), queued.end(), [center](ColumnCoord a, ColumnCoord b)
+    {
+        int da = (a.x - center.x) * (a.x - center.x) + (a.z - center.z) * (a.z - center.z);
+        int db = (b.x - center.x) * (b.x - center.x) + (b.z - center.z) * (b.z - center.z);
+        return std::tie(da, a.x, a.z) < std::tie(db, b.x, b.z);
+    });
+    m_lodRemeshQueue.insert(m_lodRemeshQueue.end(), queued.begin(), queued.end());
+}
+
+void VoxelWorld::requestLodRemeshes()
+{
+    // spread over frames like the uploads, a band crossing otherwise remeshes hundreds of sections at once
+    // and held back while the pool is behind, every request in flight holds a padded copy
+    size_t maxInFlight = m_scheduler.getThreadCount() * 32;
+    size_t requested = 0;
+    while (!m_lodRemeshQueue.empty() && requested < lodRemeshBudget && (size_t)m_meshesInFlight < maxInFlight)
+    {
+        ColumnCoord coord = m_lodRemeshQueue.front();
+        m_lodRemeshQueue.pop_front();
+        m_lodRemeshQueued.erase(coord);
+
+        if (!findColumn(coord) || !hasAllNeighbors(coord)) continue;
+        requestColumnMeshes(coord);
+        requested++;
+    }
+}
+
+void VoxelWorld::remeshDirtyChunks()
+{
+    // urgent so edits show up next to the player before any bulk streaming work
+    for (const ChunkCoord& coord : m_dirtyChunks)
+    {
+        if (!findChunk(coord)) continue; // unloaded since the edit
+        // light spread into a column still waiting on its neighbours, it is meshed once they are in
+        if (!hasAllNeighbors({ coord.x, coord.z })) continue;
+        requestMesh(coord, true);
+        m_editRemeshCount++;
+    }
+    m_dirtyChunks.clear();
+}
+
+void VoxelWorld::uploadCompletedMeshes()
+{
+    // take what fits in this frame's budget, upload outside the lock
+    std::vector<std::pair<Chunk*, CompletedMesh>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        size_t budgetUsed = 0;
+        while (!m_completedMeshes.empty() && (ready.empty() || budgetUsed < meshUploadBudgetBytes))
+        {
+            CompletedMesh& mesh = m_completedMeshes.front();
 
-                    if (height >= CHUNK_SIZE) height = CHUNK_SIZE - 1;
-                    if (height < 0) height = 0;
+            // unloaded meanwhile, or a newer request for this chunk is on its way
+            Chunk* chunk = findChunk(mesh.coord);
+            if (chunk && mesh.revision == chunk->getMeshRevision())
+            {
+                budgetUsed += mesh.vertices.size() * sizeof(PackedVertex);
+                ready.emplace_back(chunk, std::move(mesh));
+            }
+            m_completedMeshes.pop_front();
+        }
+    }
+
+    size_t uploadedBefore = m_meshArena.getUploadedBytes();
+    size_t fenceWaitsBefore = m_meshArena.getFenceWaits();
+    for (const auto& [chunk, mesh] : ready)
+    {
+        chunk->uploadMesh(m_meshArena, mesh.vertices, mesh.bounds, mesh.lod);
+        chunk->setConnectivity(mesh.connectivity);
+    }
+    m_meshArena.finishUploads();
+    m_uploadedMeshes += ready.size();
+    m_frameUploadBytes = m_meshArena.getUploadedBytes() - uploadedBefore;
+    m_frameFenceWaits = m_meshArena.getFenceWaits() - fenceWaitsBefore;
+
+    if (m_reportRebuild && m_meshesInFlight == 0)
+    {
+        bool drained;
+        {
+            std::lock_guard<std::mutex> lock(m_completedMutex);
+            drained = m_completedMeshes.empty();
+        }
+        if (drained)
+        {
+            m_reportRebuild = false;
+
+            size_t vertexCount = 0;
+            for (const auto& [coord, chunk] : m_chunks) vertexCount += chunk->getVertexCount();
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - m_rebuildStart;
+            std::cout << "mesher: " << getMeshModeName(m_meshMode) << (m_ambientOcclusion ? " + AO" : "")
+                      << " | vertices: " << vertexCount
+                      << " | upload: " << (vertexCount * sizeof(PackedVertex)) / 1024 << " KiB"
+                      << " | arena: " << m_meshArena.getUsedVertices() * sizeof(PackedVertex) / 1024 << "/"
+                      << m_meshArena.getCapacityVertices() * sizeof(PackedVertex) / 1024 << " KiB, "
+                      << m_meshArena.getFreeBlockCount() << " free blocks, "
+                      << m_meshArena.getFenceWaits() << " fence waits"
+                      << " | build: " << elapsed.count() << " ms"
+                      << " (" << m_scheduler.getThreadCount() << " threads)" << std::endl;
+        }
+    }
+}
+
+void VoxelWorld::gatherSnapshotSources(ChunkCoord coord, SnapshotSources& sources) const
+{
+    for (int dx = -1; dx <= 1; dx++)
+    {
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dz = -1; dz <= 1; dz++)
+            {
+                ChunkCoord c{ coord.x + dx, coord.y + dy, coord.z + dz };
+                sources.sections[dx + 1][dy + 1][dz + 1] = findChunk(c);
+                sources.implicit[dx + 1][dy + 1][dz + 1] = implicitBlock(c);
+                sources.implicitLight[dx + 1][dy + 1][dz + 1] = implicitLight(implicitBlock(c));
+            }
+        }
+    }
+}
+
+void VoxelWorld::buildPaddedBlocks(const SnapshotSources& sources, PaddedBlocks& padded) const
+{
+    sources.sections[1][1][1]->copyInto(padded);
 
-                    for(int y = 0; y <= height; y++) {
-                        if (y == height) currentChunk.setBlock(x, y, z, 1);
-                        else if (y > height - 3) currentChunk.setBlock(x, y, z, 2);
-                        else currentChunk.setBlock(x, y, z, 3);
+    // shell, including edges and corners, one box per neighbour section
+    // each axis covers -1, 0..CHUNK_SIZE-1 or CHUNK_SIZE depending on the side the neighbour is on
+    for (int nx = 0; nx < 3; nx++)
+    {
+        for (int ny = 0; ny < 3; ny++)
+        {
+            for (int nz = 0; nz < 3; nz++)
+            {
+                if (nx == 1 && ny == 1 && nz == 1) continue;
+
+                int minX = nx == 0 ? -1 : (nx == 1 ? 0 : CHUNK_SIZE);
+                int maxX = nx == 1 ? CHUNK_SIZE - 1 : minX;
+                int minY = ny == 0 ? -1 : (ny == 1 ? 0 : CHUNK_SIZE);
+                int maxY = ny == 1 ? CHUNK_SIZE - 1 : minY;
+                int minZ = nz == 0 ? -1 : (nz == 1 ? 0 : CHUNK_SIZE);
+                int maxZ = nz == 1 ? CHUNK_SIZE - 1 : minZ;
+
+                const Chunk* neighbor = sources.sections[nx][ny][nz];
+                if (!neighbor)
+                {
+                    BlockID block = sources.implicit[nx][ny][nz];
+                    uint8_t light = sources.implicitLight[nx][ny][nz];
+                    for (int y = minY; y <= maxY; y++)
+                    {
+                        for (int z = minZ; z <= maxZ; z++)
+                        {
+                            for (int x = minX; x <= maxX; x++)
+                            {
+                                padded.set(x, y, z, block);
+                                padded.setLight(x, y, z, light);
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                // padded coords to the neighbour's own
+                int offsetX = (nx - 1) * CHUNK_SIZE;
+                int offsetY = (ny - 1) * CHUNK_SIZE;
+                int offsetZ = (nz - 1) * CHUNK_SIZE;
+                for (int y = minY; y <= maxY; y++)
+                {
+                    for (int z = minZ; z <= maxZ; z++)
+                    {
+                        for (int x = minX; x <= maxX; x++)
+                        {
+                            padded.set(x, y, z, neighbor->getBlock(x - offsetX, y - offsetY, z - offsetZ));
+                            padded.setLight(x, y, z, neighbor->getLight(x - offsetX, y - offsetY, z - offsetZ));
+                        }
                     }
                 }
             }
-            currentChunk.updateMesh();
         }
     }
-    std::cout << "generation complete!" << std::endl;
+}
+
+void VoxelWorld::waitForSnapshots(ChunkCoord from, ChunkCoord to) const
+{
+    // snapshots go out as urgent tasks, they are the next thing every worker picks up
+    // the reader counts drop on the workers, m_snapshotDone wakes this up after each one instead of a spin
+    std::unique_lock<std::mutex> lock(m_snapshotMutex);
+    for (int x = from.x; x <= to.x; x++)
+    {
+        for (int y = from.y; y <= to.y; y++)
+        {
+            for (int z = from.z; z <= to.z; z++)
+            {
+                const Chunk* chunk = findChunk({ x, y, z });
+                if (!chunk) continue;
+                m_snapshotDone.wait(lock, [chunk] { return !chunk->hasSnapshotReaders(); });
+            }
+        }
+    }
+}
+
+void VoxelWorld::requestMesh(ChunkCoord coord, bool urgent)
+{
+    Chunk* chunk = findChunk(coord);
+    if (!chunk) return;
+
+    uint64_t revision = ++m_meshRevision;
+    chunk->setMeshRevision(revision);
+
+    // the copy is all the mesher sees, later edits go through a new request
+    SnapshotSources sources;
+    gatherSnapshotSources(coord, sources);
+
+    MeshMode mode = m_meshMode;
+    bool ambientOcclusion = m_ambientOcclusion;
+    const ChunkColumn* column = findColumn({ coord.x, coord.z });
+    int lod = column ? column->lod : 0;
+
+    // skirts on the sides facing a column at another level, the seams there dont line up
+    int skirtFaces = 0;
+    for (int face = 0; face < 4; face++)
+    {
+        const ChunkColumn* neighbor = findColumn({ coord.x + cubeFaceNormals[face][0], coord.z + cubeFaceNormals[face][2] });
+        if (neighbor && neighbor->lod != lod) skirtFaces |= 1 << face;
+    }
+
+    for (const auto& plane : sources.sections)
+    {
+        for (const auto& row : plane)
+        {
+            for (const Chunk* section : row)
+            {
+                if (section) section->addSnapshotReader();
+            }
+        }
+    }
+
+    m_meshesInFlight++;
+    m_scheduler.submit([this, coord, revision, sources, mode, ambientOcclusion, lod, skirtFaces, urgent]()
+    {
+        auto padded = std::make_shared<PaddedBlocks>();
+        buildPaddedBlocks(sources, *padded);
+        for (const auto& plane : sources.sections)
+        {
+            for (const auto& row : plane)
+            {
+                for (const Chunk* section : row)
+                {
+                    if (section) section->removeSnapshotReader();
+                }
+            }
+        }
+        // taking the lock orders the drop before a waiter's next check, so the wake up cant slip in between
+        {
+            std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        }
+        m_snapshotDone.notify_all();
+
+        m_scheduler.submit([this, coord, revision, padded, mode, ambientOcclusion, lod, skirtFaces]()
+        {
+            CompletedMesh mesh{ coord, revision, {}, {}, ALL_FACES_CONNECTED, lod };
+            if (lod > 0)
+            {
+                PaddedBlocks downsampled;
+                downsampleBlocks(*padded, lod, skirtFaces, downsampled);
+                buildChunkMesh(downsampled, mode, ambientOcclusion, mesh.vertices);
+            }
+            else buildChunkMesh(*padded, mode, ambientOcclusion, mesh.vertices);
+            mesh.bounds = computeMeshBounds(mesh.vertices.data(), mesh.vertices.size());
+            mesh.connectivity = computeFaceConnectivity(*padded);
+            {
+                std::lock_guard<std::mutex> lock(m_completedMutex);
+                m_completedMeshes.push_back(std::move(mesh));
+            }
+            m_meshesInFlight--;
+        }, urgent);
+    }, true);
 }
 
 int VoxelWorld::getBlock(int x, int y, int z) const
 {
-    if (y < 0 || y >= CHUNK_SIZE) return 0;
+    if (y < 0 || y >= WORLD_SECTIONS * CHUNK_SIZE) return 0;
 
-    int chunkX = x / CHUNK_SIZE;
-    int chunkZ = z / CHUNK_SIZE;
+    ChunkCoord coord{ floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE) };
+    if (const Chunk* chunk = findChunk(coord))
+    {
+        return chunk->getBlock(floorMod(x, CHUNK_SIZE), floorMod(y, CHUNK_SIZE), floorMod(z, CHUNK_SIZE));
+    }
+    return implicitBlock(coord);
+}
 
-    if (x < 0) chunkX = (x - CHUNK_SIZE + 1) / CHUNK_SIZE;
-    if (z < 0) chunkZ = (z - CHUNK_SIZE + 1) / CHUNK_SIZE;
+size_t VoxelWorld::raycast(const Ray* rays, RaycastResult* results, size_t count) const
+{
+    // the chunk constant, region sizes as shifts so the walk never divides
+    static constexpr int SIZE = ::CHUNK_SIZE;
+    static constexpr int CHUNK_SHIFT = 5;
+    static_assert(SIZE == 1 << CHUNK_SHIFT && BRICK_SIZE == 1 << BRICK_SHIFT);
+    const int worldHeight = WORLD_SECTIONS * SIZE;
 
-    if (chunkX < 0 || chunkX >= WORLD_SIZE || chunkZ < 0 || chunkZ >= WORLD_SIZE) return 0;
+    // sections looked up so far in this batch, slot = low 2 bits of each coord
+    // rays from one place keep crossing the same few, each is hashed once instead of on every crossing
+    struct CachedSection
+    {
+        ChunkCoord coord;
+        const Chunk* chunk;
+        BlockID implicit;
+        bool valid;
+    };
+    std::array<CachedSection, 64> sections;
+    for (CachedSection& section : sections) section.valid = false;
 
-    int localX = x % CHUNK_SIZE;
-    int localZ = z % CHUNK_SIZE;
-    if (localX < 0) localX += CHUNK_SIZE;
-    if (localZ < 0) localZ += CHUNK_SIZE;
+    // section the walk is in, origin = its first block
+    int cachedOrigin[3] = { 0, 0, 0 };
+    const CachedSection* current = nullptr;
+    size_t steps = 0;
 
-    int chunkIndex = chunkX + (chunkZ * WORLD_SIZE);
-    return m_chunks[chunkIndex].getBlock(localX, y, localZ);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Ray& ray = rays[i];
+        RaycastResult& result = results[i];
+        result = { false, 0, 0, 0, glm::vec3(0.0f), 0.0f };
+
+        RayWalk walk;
+        for (int a = 0; a < 3; a++)
+        {
+            float origin = ray.origin[a];
+            float direction = ray.direction[a];
+            walk.cell[a] = (int)std::floor(origin);
+            walk.step[a] = direction > 0 ? 1 : -1;
+            walk.delta[a] = direction == 0 ? 1e30f : std::abs(1.0f / direction);
+            walk.rate[a] = std::abs(direction);
+            walk.side[a] = direction < 0 ? (origin - walk.cell[a]) * walk.delta[a] : (walk.cell[a] + 1.0f - origin) * walk.delta[a];
+        }
+        walk.t = 0.0f;
+        walk.axis = -1;
+
+        while (walk.t <= ray.maxDistance)
+        {
+            steps++;
+            int shift = 0;
+            BlockID block = 0;
+            if (walk.cell[1] < 0 || walk.cell[1] >= worldHeight)
+            {
+                // past the top or bottom, getBlock reads air there too
+                shift = CHUNK_SHIFT;
+            }
+            else
+            {
+                int x = walk.cell[0] - cachedOrigin[0];
+                int y = walk.cell[1] - cachedOrigin[1];
+                int z = walk.cell[2] - cachedOrigin[2];
+                if (!current || (unsigned)(x | y | z) >= (unsigned)SIZE)
+                {
+                    ChunkCoord coord{ walk.cell[0] >> CHUNK_SHIFT, walk.cell[1] >> CHUNK_SHIFT, walk.cell[2] >> CHUNK_SHIFT };
+                    CachedSection& section = sections[(coord.x & 3) | ((coord.y & 3) << 2) | ((coord.z & 3) << 4)];
+                    if (!section.valid || !(section.coord == coord))
+                    {
+                        section.coord = coord;
+                        section.chunk = findChunk(coord);
+                        section.implicit = section.chunk ? 0 : implicitBlock(coord);
+                        section.valid = true;
+                    }
+                    current = &section;
+                    cachedOrigin[0] = coord.x * SIZE;
+                    cachedOrigin[1] = coord.y * SIZE;
+                    cachedOrigin[2] = coord.z * SIZE;
+                    x = walk.cell[0] - cachedOrigin[0];
+                    y = walk.cell[1] - cachedOrigin[1];
+                    z = walk.cell[2] - cachedOrigin[2];
+                }
+
+                if (const Chunk* chunk = current->chunk)
+                {
+                    if (chunk->isEmpty()) shift = CHUNK_SHIFT;
+                    else if (chunk->isBrickEmpty(x, y, z)) shift = BRICK_SHIFT;
+                    else block = chunk->getBlock(x, y, z);
+                }
+                else if (current->implicit == 0) shift = CHUNK_SHIFT; // implicit air, or a column that isnt loaded
+                else block = current->implicit;
+            }
+
+            if (block != 0 && walk.axis >= 0)
+            {
+                result.hit = true;
+                result.x = walk.cell[0];
+                result.y = walk.cell[1];
+                result.z = walk.cell[2];
+                result.normal[walk.axis] = (float)-walk.step[walk.axis];
+                result.distance = walk.t;
+                break;
+            }
+            if (shift == 0) stepCell(walk);
+            else leaveRegion(walk, shift);
+        }
+    }
+    return steps;
+}
+
+RaycastResult VoxelWorld::raycast(const Ray& ray) const
+{
+    RaycastResult result;
+    raycast(&ray, &result, 1);
+    return result;
+}
+
+bool VoxelWorld::isColumnLoaded(int x, int z) const
+{
+    return findColumn({ floorDiv(x, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE) }) != nullptr;
+}
+
+int VoxelWorld::getSurfaceHeight(int x, int z) const
+{
+    int columnX = floorDiv(x, CHUNK_SIZE);
+    int columnZ = floorDiv(z, CHUNK_SIZE);
+    const ChunkColumn* column = findColumn({ columnX, columnZ });
+    if (!column) return -1;
+
+    int localX = floorMod(x, CHUNK_SIZE);
+    int localZ = floorMod(z, CHUNK_SIZE);
+    for (int cy = WORLD_SECTIONS - 1; cy >= column->solidSections; cy--)
+    {
+        // missing sections above the solid ones are air
+        const Chunk* chunk = findChunk({ columnX, cy, columnZ });
+        if (!chunk) continue;
+
+        int height = chunk->getHeight(localX, localZ);
+        if (height >= 0) return cy * CHUNK_SIZE + height;
+    }
+    return column->solidSections * CHUNK_SIZE - 1;
 }
 
 void VoxelWorld::setBlock(int x, int y, int z, int type)
 {
-    if (y < 0 || y >= CHUNK_SIZE) return;
+    if (y < 0 || y >= WORLD_SECTIONS * CHUNK_SIZE) return;
+
+    ChunkCoord coord{ floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE) };
+    // light spreads at most 15 blocks sideways, but sky light runs straight down a shaft for any depth,
+    // so every section of this column and the ones around it can be relit (or materialized)
+    waitForSnapshots({ coord.x - 1, 0, coord.z - 1 }, { coord.x + 1, WORLD_SECTIONS - 1, coord.z + 1 });
+    Chunk* chunk = findChunk(coord);
+    if (!chunk)
+    {
+        // editing a uniform section gives it real blocks, unless nothing would change
+        if (implicitBlock(coord) == type) return;
+        chunk = materializeChunk(coord);
+        if (!chunk) return;
+    }
+
+    int localX = floorMod(x, CHUNK_SIZE);
+    int localY = floorMod(y, CHUNK_SIZE);
+    int localZ = floorMod(z, CHUNK_SIZE);
+
+    // nothing changes, nothing to save or remesh
+    if (chunk->getBlock(localX, localY, localZ) == type) return;
+
+    chunk->setBlock(localX, localY, localZ, type);
+    m_dirtyColumns.insert({ coord.x, coord.z });
+    m_dirtyChunks.insert(coord);
+    m_editCount++;
+
+    m_lastEditLightCells = updateLight(x, y, z, (BlockID)type);
+    m_editLightCells += m_lastEditLightCells;
+    m_maxEditLightCells = std::max(m_maxEditLightCells, m_lastEditLightCells);
+
+    // every neighbour whose padded shell holds this block, edges and corners included
+    // a corner block sits in the shell of 7 other chunks, a plain border block in 1
+    int xs[2] = { 0, localX == 0 ? -1 : (localX == CHUNK_SIZE - 1 ? 1 : 0) };
+    int ys[2] = { 0, localY == 0 ? -1 : (localY == CHUNK_SIZE - 1 ? 1 : 0) };
+    int zs[2] = { 0, localZ == 0 ? -1 : (localZ == CHUNK_SIZE - 1 ? 1 : 0) };
+    for (int i = 0; i < (xs[1] ? 2 : 1); i++)
+    {
+        for (int j = 0; j < (ys[1] ? 2 : 1); j++)
+        {
+            for (int k = 0; k < (zs[1] ? 2 : 1); k++)
+            {
+                if (i == 0 && j == 0 && k == 0) continue;
+
+                ChunkCoord neighbor{ coord.x + xs[i], coord.y + ys[j], coord.z + zs[k] };
+                // digging next to an implicit stone section exposes its faces, so it gets real blocks
+                // only face neighbours can show a face, diagonal ones just need the new shell
+                bool faceNeighbor = (i + j + k) == 1;
+                if (!findChunk(neighbor))
+                {
+                    if (!faceNeighbor || type != 0 || implicitBlock(neighbor) == 0) continue;
+                    materializeChunk(neighbor);
+                }
+                m_dirtyChunks.insert(neighbor);
+            }
+        }
+    }
+}
+
+size_t VoxelWorld::updateLight(int x, int y, int z, BlockID type)
+{
+    WorldLightAccess access(*this);
+    size_t touched = 0;
+
+    for (LightChannel channel : { LightChannel::Sky, LightChannel::Block })
+    {
+        BlockID block;
+        uint8_t light;
+        access.getCell(x, y, z, block, light);
+
+        // 1- whatever light the cell had goes, along with everything lit through it
+        int level = getChannelLight(light, channel);
+        if (level > 0)
+        {
+            access.setLight(x, y, z, setChannelLight(light, channel, 0));
+            m_lightRemovals.push_back({ x, y, z, level });
+            touched += removeLight(access, channel, m_lightRemovals, m_lightQueue);
+        }
+
+        // 2- an emitter shines on its own, air takes light from around it
+        int emission = channel == LightChannel::Block ? getBlockEmission(type) : 0;
+        if (emission > 0)
+        {
+            access.getCell(x, y, z, block, light);
+            access.setLight(x, y, z, setChannelLight(light, channel, emission));
+            m_lightQueue.push_back({ x, y, z });
+        }
+        else if (type == 0)
+        {
+            for (int f = 0; f < 6; f++) m_lightQueue.push_back({ x + cubeFaceNormals[f][0], y + cubeFaceNormals[f][1], z + cubeFaceNormals[f][2] });
+
+            // nothing above the top layer to take sky light from
+            if (channel == LightChannel::Sky && y == WORLD_SECTIONS * CHUNK_SIZE - 1)
+            {
+                access.getCell(x, y, z, block, light);
+                access.setLight(x, y, z, setChannelLight(light, channel, MAX_LIGHT));
+                m_lightQueue.push_back({ x, y, z });
+            }
+        }
+        touched += spreadLight(access, channel, m_lightQueue);
+    }
+    return touched;
+}
+
+void VoxelWorld::blendColumnLight(ColumnCoord coord)
+{
+    WorldLightAccess access(*this);
+
+    for (LightChannel channel : { LightChannel::Sky, LightChannel::Block })
+    {
+        for (int face = 0; face < 4; face++)
+        {
+            ColumnCoord other{ coord.x + cubeFaceNormals[face][0], coord.z + cubeFaceNormals[face][2] };
+            if (!findColumn(other)) continue;
+
+            for (int cy = 0; cy < WORLD_SECTIONS; cy++)
+            {
+                ChunkCoord here{ coord.x, cy, coord.z };
+                ChunkCoord there{ other.x, cy, other.z };
+                const Chunk* a = findChunk(here);
+                const Chunk* b = findChunk(there);
+                // two implicit sections are lit the same on both sides, or stone stops it
+                if (!a && !b) continue;
+
+                BlockID implicitA = implicitBlock(here);
+                BlockID implicitB = implicitBlock(there);
+                for (int v = 0; v < CHUNK_SIZE; v++)
+                {
+                    for (int u = 0; u < CHUNK_SIZE; u++)
+                    {
+                        // p = cell on this column's side of the face, q = the one across it
+                        int p[3];
+                        int q[3];
+                        p[1] = q[1] = v;
+                        if (face < 2)
+                        {
+                            p[0] = q[0] = u;
+                            p[2] = face == 0 ? CHUNK_SIZE - 1 : 0;
+                            q[2] = CHUNK_SIZE - 1 - p[2];
+                        }
+                        else
+                        {
+                            p[2] = q[2] = u;
+                            p[0] = face == 3 ? CHUNK_SIZE - 1 : 0;
+                            q[0] = CHUNK_SIZE - 1 - p[0];
+                        }
+
+                        BlockID blockA = a ? a->getBlock(p[0], p[1], p[2]) : implicitA;
+                        BlockID blockB = b ? b->getBlock(q[0], q[1], q[2]) : implicitB;
+                        int levelA = getChannelLight(a ? a->getLight(p[0], p[1], p[2]) : implicitLight(implicitA), channel);
+                        int levelB = getChannelLight(b ? b->getLight(q[0], q[1], q[2]) : implicitLight(implicitB), channel);
+
+                        // the brighter side spreads into darker air across the face
+                        if (blockB == 0 && levelA > levelB + 1)
+                        {
+                            m_lightQueue.push_back({ coord.x * CHUNK_SIZE + p[0], cy * CHUNK_SIZE + p[1], coord.z * CHUNK_SIZE + p[2] });
+                        }
+                        else if (blockA == 0 && levelB > levelA + 1)
+                        {
+                            m_lightQueue.push_back({ other.x * CHUNK_SIZE + q[0], cy * CHUNK_SIZE + q[1], other.z * CHUNK_SIZE + q[2] });
+                        }
+                    }
+                }
+            }
+        }
+        spreadLight(access, channel, m_lightQueue);
+    }
+}
+
+void VoxelWorld::markLightDirty(ChunkCoord coord, int x, int y, int z)
+{
+    // a face shows the light of the cell in front of it, so across a border only the face neighbour cares
+    m_dirtyChunks.insert(coord);
+    if (x == 0) m_dirtyChunks.insert({ coord.x - 1, coord.y, coord.z });
+    if (x == CHUNK_SIZE - 1) m_dirtyChunks.insert({ coord.x + 1, coord.y, coord.z });
+    if (y == 0) m_dirtyChunks.insert({ coord.x, coord.y - 1, coord.z });
+    if (y == CHUNK_SIZE - 1) m_dirtyChunks.insert({ coord.x, coord.y + 1, coord.z });
+    if (z == 0) m_dirtyChunks.insert({ coord.x, coord.y, coord.z - 1 });
+    if (z == CHUNK_SIZE - 1) m_dirtyChunks.insert({ coord.x, coord.y, coord.z + 1 });
+}
+
+bool VoxelWorld::isMeshInFrustum(ChunkCoord coord, const Chunk& chunk, const Frustum& frustum) const
+{
+    // tested against the mesh box, not the whole section, so flat ground chunks stay thin
+    glm::vec3 origin(coord.x * CHUNK_SIZE, coord.y * CHUNK_SIZE, coord.z * CHUNK_SIZE);
+    const MeshBounds& bounds = chunk.getMeshBounds();
+    float scale = (float)(1 << chunk.getMeshLod());
+    glm::vec3 boxMin = origin + glm::vec3((float)bounds.minX, (float)bounds.minY, (float)bounds.minZ) * scale;
+    glm::vec3 boxMax = origin + glm::vec3((float)bounds.maxX, (float)bounds.maxY, (float)bounds.maxZ) * scale;
+    return frustum.intersectsBox(boxMin, boxMax);
+}
 
-    int chunkX = x / CHUNK_SIZE;
-    int chunkZ = z / CHUNK_SIZE;
+size_t VoxelWorld::drawReachableChunks(ChunkCoord start, const Frustum& frustum, int render_distance)
+{
+    ColumnCoord center{ start.x, start.z };
+    auto inRange = [center, render_distance](ChunkCoord c)
+    {
+        int dx = c.x - center.x;
+        int dz = c.z - center.z;
+        return dx * dx + dz * dz < render_distance * render_distance;
+    };
 
-    if (x < 0) chunkX = (x - CHUNK_SIZE + 1) / CHUNK_SIZE;
-    if (z < 0) chunkZ = (z - CHUNK_SIZE + 1) / CHUNK_SIZE;
+    m_visibilityQueue.clear();
+    m_visibilityVisited.clear();
+    m_visibilityQueue.push_back({ start, -1, 0 });
+    m_visibilityVisited.insert(start);
 
-    if (chunkX < 0 || chunkX >= WORLD_SIZE || chunkZ < 0 || chunkZ >= WORLD_SIZE) return;
+    size_t drawn = 0;
+    for (size_t head = 0; head < m_visibilityQueue.size(); head++)
+    {
+        VisibilityStep step = m_visibilityQueue[head];
+
+        // sections that arent allocated are all air (open) or all stone (closed), unloaded columns stop the search
+        FaceConnectivity connectivity;
+        if (const Chunk* chunk = findChunk(step.coord))
+        {
+            connectivity = chunk->getConnectivity();
+            if (chunk->getVertexCount() > 0 && isMeshInFrustum(step.coord, *chunk, frustum))
+            {
+                m_meshArena.addDraw(chunk->getMesh(), glm::vec3(step.coord.x * CHUNK_SIZE, step.coord.y * CHUNK_SIZE, step.coord.z * CHUNK_SIZE),
+                                    (float)(1 << chunk->getMeshLod()));
+                drawn++;
+            }
+        }
+        else if (step.entryFace < 0 || findColumn({ step.coord.x, step.coord.z }))
+        {
+            connectivity = implicitBlock(step.coord) == 0 ? ALL_FACES_CONNECTED : 0;
+        }
+        else continue;
 
-    int localX = x % CHUNK_SIZE;
-    int localZ = z % CHUNK_SIZE;
-    if (localX < 0) localX += CHUNK_SIZE;
-    if (localZ < 0) localZ += CHUNK_SIZE;
+        for (int face = 0; face < 6; face++)
+        {
+            // never back towards the camera, and only out through a face the entry face can see
+            if (step.directions & (1 << (face ^ 1))) continue;
+            if (step.entryFace >= 0 && !facesConnected(connectivity, step.entryFace, face)) continue;
 
-    int chunkIndex = chunkX + (chunkZ * WORLD_SIZE);
-    m_chunks[chunkIndex].setBlock(localX, y, localZ, type);
-    m_chunks[chunkIndex].updateMesh();
+            ChunkCoord next{ step.coord.x + cubeFaceNormals[face][0], step.coord.y + cubeFaceNormals[face][1], step.coord.z + cubeFaceNormals[face][2] };
+            if (next.y < 0 || next.y >= WORLD_SECTIONS || !inRange(next)) continue;
+            if (m_visibilityVisited.count(next)) continue;
 
-    // neighbor
-    if (localX == 0 && chunkX > 0) 
-        m_chunks[(chunkX - 1) + (chunkZ * WORLD_SIZE)].updateMesh();
-    else if (localX == CHUNK_SIZE - 1 && chunkX < WORLD_SIZE - 1) 
-        m_chunks[(chunkX + 1) + (chunkZ * WORLD_SIZE)].updateMesh();
+            // whole section box here, the mesh box of an air section is empty but the search has to pass through it
+            glm::vec3 origin(next.x * CHUNK_SIZE, next.y * CHUNK_SIZE, next.z * CHUNK_SIZE);
+            if (!frustum.intersectsBox(origin, origin + glm::vec3((float)CHUNK_SIZE))) continue;
 
-    if (localZ == 0 && chunkZ > 0) 
-        m_chunks[chunkX + ((chunkZ - 1) * WORLD_SIZE)].updateMesh();
-    else if (localZ == CHUNK_SIZE - 1 && chunkZ < WORLD_SIZE - 1) 
-        m_chunks[chunkX + ((chunkZ + 1) * WORLD_SIZE)].updateMesh();
+            m_visibilityVisited.insert(next);
+            m_visibilityQueue.push_back({ next, face ^ 1, step.directions | (1 << face) });
+        }
+    }
+    return drawn;
 }
 
-void VoxelWorld::render(Shader& shader, glm::vec3 playerPos, int render_distance)
+void VoxelWorld::render(const glm::mat4& viewProjection, glm::vec3 playerPos, int render_distance)
 {
-    int playerChunkX = (int)(playerPos.x / CHUNK_SIZE);
-    int playerChunkZ = (int)(playerPos.z / CHUNK_SIZE);
+    ChunkCoord start{
+        floorDiv((int)std::floor(playerPos.x), CHUNK_SIZE),
+        std::clamp(floorDiv((int)std::floor(playerPos.y), CHUNK_SIZE), 0, WORLD_SECTIONS - 1),
+        floorDiv((int)std::floor(playerPos.z), CHUNK_SIZE)
+    };
+    Frustum frustum = Frustum::fromMatrix(viewProjection);
 
-    for(int cx = 0; cx < WORLD_SIZE; cx++)
+    m_visibleChunks = 0;
+    m_culledChunks = 0;
+    m_occludedChunks = 0;
+    if (occlusionCulling) m_visibleChunks = drawReachableChunks(start, frustum, render_distance);
+
+    // plain path: every meshed chunk in range is drawn or frustum culled
+    // with occlusion culling the BFS drew already, the same walk only sorts the rest into culled and occluded
+    if (!occlusionCulling || countCulledChunks)
     {
-        for(int cz = 0; cz < WORLD_SIZE; cz++)
+        for (const auto& [coord, chunk] : m_chunks)
         {
-            int dist = sqrt(pow(cx - playerChunkX, 2) + pow(cz - playerChunkZ, 2));
-            if (dist < render_distance)
+            if (chunk->getVertexCount() == 0) continue;
+
+            int dx = coord.x - start.x;
+            int dz = coord.z - start.z;
+            if (dx * dx + dz * dz >= render_distance * render_distance) continue;
+
+            if (!isMeshInFrustum(coord, *chunk, frustum)) m_culledChunks++;
+            else if (occlusionCulling)
             {
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(cx * CHUNK_SIZE, 0.0f, cz * CHUNK_SIZE));
-                shader.setMat4("model", model);
-                m_chunks[cx + cz * WORLD_SIZE].render();
+                if (!m_visibilityVisited.count(coord)) m_occludedChunks++;
+            }
+            else
+            {
+                m_meshArena.addDraw(chunk->getMesh(), glm::vec3(coord.x * CHUNK_SIZE, coord.y * CHUNK_SIZE, coord.z * CHUNK_SIZE),
+                                    (float)(1 << chunk->getMeshLod()));
+                m_visibleChunks++;
             }
         }
     }
-}
\ No newline at end of file
+
+    // one call for everything visible
+    m_meshArena.drawAll();
+}
@@ -1,29 +1,338 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Chunk.h"
+#include "ChunkCoord.h"
+#include "ChunkMesher.h"
+#include "Frustum.h"
+#include "Lighting.h"
+#include "Noise.h"
+#include "RegionStore.h"
+#include "TaskScheduler.h"
 #include "Shader.h"
-#include "stb_perlin.h"
+
+// distances are in lengths of direction, blocks when it is normalized
+struct Ray
+{
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float maxDistance;
+};
+
+struct RaycastResult
+{
+    bool hit;
+    int x, y, z;
+    glm::vec3 normal; // face the ray came in through
+    float distance;   // where it entered the hit block
+};
 
 class VoxelWorld
 {
 public:
     // settings
-    const int WORLD_SIZE = 5;
     const int CHUNK_SIZE = 32;
+    // vertical sections per column, world height = WORLD_SECTIONS * CHUNK_SIZE
+    const int WORLD_SECTIONS = 8;
+
+    // streaming, in columns around the player
+    // columns load inside loadRadius and unload past unloadRadius, the gap stops border thrashing
+    int loadRadius = 24;
+    int unloadRadius = 26;
+
+    // column distance where each coarser mesh level starts, lod 3 runs out to the load radius
+    int lodDistances[LOD_LEVELS - 1] = { 6, 12, 18 };
+    // a column keeps its level until it is this many columns past the band edge, walking along an edge doesnt remesh the ring every step
+    int lodHysteresis = 1;
+    // columns remeshed per frame for a level change, the rest wait for the next frames
+    size_t lodRemeshBudget = 8;
+
+    // terrain noise seed, a seed makes the same world on any cpu
+    uint32_t seed = 1;
+
+    // GL upload budget per frame, at least one mesh always goes through
+    size_t meshUploadBudgetBytes = 512 * 1024;
+
+    // only draw chunks reachable from the camera through connected air (see render)
+    bool occlusionCulling = true;
+    // with occlusion culling the culled / occluded counters need a pass over every loaded chunk,
+    // it only runs in renders with this set (the frames that show the stats), the drawn count is always there
+    bool countCulledChunks = false;
+
+    // workerThreads = 0 picks one per core, generation and meshing share the pool
+    // saveDirectory holds the region files, empty = nothing is loaded from or saved to disk
+    explicit VoxelWorld(unsigned int workerThreads = 0, const std::string& saveDirectory = "world");
+
+    // blocking load of everything in loadRadius, used at startup so the player has ground
+    void generateAround(glm::vec3 center);
 
-    VoxelWorld();
+    // once per frame on the GL thread
+    // streams columns in/out around playerPos and uploads finished meshes within the budget
+    void update(glm::vec3 playerPos);
+
+    // writes every column that changed since it was loaded, unloaded columns are saved as they go
+    void save();
 
     int getBlock(int x, int y, int z) const;
     void setBlock(int x, int y, int z, int type);
 
-    void render(Shader& shader, glm::vec3 playerPos, int render_distance);
+    // first solid block along each ray, the block the ray starts in is never hit
+    // empty sections and empty 4^3 bricks are crossed in one step, only cells in bricks with blocks are read
+    // sections are looked up once for the whole batch while rays stay in them, returns the walk steps taken
+    size_t raycast(const Ray* rays, RaycastResult* results, size_t count) const;
+    RaycastResult raycast(const Ray& ray) const;
+
+    // world y of the highest solid block at x,z, -1 when the column isnt loaded or has nothing solid
+    // reads the section heightmaps top down, no block probing
+    int getSurfaceHeight(int x, int z) const;
+    // column holding block x,z is in memory, over one that isnt everything reads as air
+    bool isColumnLoaded(int x, int z) const;
+
+    // draws the chunks within render_distance columns that touch the view frustum
+    // with occlusionCulling, a BFS from the camera section only crosses chunk faces that see each other
+    void render(const glm::mat4& viewProjection, glm::vec3 playerPos, int render_distance);
+
+    // chunks with a mesh drawn / skipped by the frustum test / pruned by the occlusion BFS in the last render
+    // culled and occluded stay 0 in an occlusion culled render without countCulledChunks
+    size_t getVisibleChunkCount() const { return m_visibleChunks; }
+    size_t getCulledChunkCount() const { return m_culledChunks; }
+    size_t getOccludedChunkCount() const { return m_occludedChunks; }
+
+    // mesh bytes copied to the GPU / staging fence stalls in the last update
+    size_t getFrameUploadBytes() const { return m_frameUploadBytes; }
+    size_t getFrameFenceWaits() const { return m_frameFenceWaits; }
+
+    // switch mesher and rebuild every chunk, prints vertex count and build time
+    void setMeshMode(MeshMode mode);
+    MeshMode getMeshMode() const { return m_meshMode; }
+    // per vertex ambient occlusion on/off, rebuilds every chunk the same way
+    void setAmbientOcclusion(bool enabled);
+    bool getAmbientOcclusion() const { return m_ambientOcclusion; }
 
-    const std::vector<Chunk>& getChunks() const { return m_chunks; }
+    // edits vs remeshes they caused, edits in the same frame share one rebuild per chunk
+    size_t getEditCount() const { return m_editCount; }
+    size_t getEditRemeshCount() const { return m_editRemeshCount; }
+    // cells the light fills changed because of edits, in total / for the last edit / for the worst one
+    size_t getEditLightCells() const { return m_editLightCells; }
+    size_t getLastEditLightCells() const { return m_lastEditLightCells; }
+    size_t getMaxEditLightCells() const { return m_maxEditLightCells; }
+
+    size_t getLoadedColumnCount() const { return m_columns.size(); }
+    // allocated sections, uniform sky/underground sections are not counted
+    size_t getLoadedChunkCount() const { return m_chunks.size(); }
+    // allocated section at coord, nullptr for an implicit one or an unloaded column
+    const Chunk* getChunk(ChunkCoord coord) const { return findChunk(coord); }
+    // coords of every allocated section, in no particular order
+    std::vector<ChunkCoord> getChunkCoords() const;
+    // full size copy of the chunk and the 1 block shell around it, what a lod 0 mesh request meshes, main thread
+    void copyPadded(ChunkCoord coord, PaddedBlocks& padded) const;
+    // totals since startup: columns and allocated sections added to the world, chunk meshes that reached the arena (remeshes included)
+    size_t getInsertedColumnCount() const { return m_insertedColumns; }
+    size_t getInsertedChunkCount() const { return m_insertedChunks; }
+    size_t getUploadedMeshCount() const { return m_uploadedMeshes; }
+    // pool size actually running, workerThreads = 0 resolved to the core count
+    unsigned int getWorkerThreadCount() const { return m_scheduler.getThreadCount(); }
 
 private:
-    std::vector<Chunk> m_chunks;
+    // what a column knows about the sections it didnt allocate
+    // sections below solidSections are all stone, sections not in m_chunks above that are all air
+    struct ChunkColumn
+    {
+        int solidSections = 0;
+        int lod = 0; // level its sections are meshed at, not saved
+    };
+
+    // mesh built by a worker, waiting for its GL upload
+    // what a mesh snapshot reads, the 3x3x3 sections around a chunk, looked up on the main thread
+    // unallocated sections are null and uniform, their block and light come from the column
+    struct SnapshotSources
+    {
+        const Chunk* sections[3][3][3];
+        BlockID implicit[3][3][3];
+        uint8_t implicitLight[3][3][3];
+    };
+
+    struct CompletedMesh
+    {
+        ChunkCoord coord;
+        uint64_t revision;
+        std::vector<PackedVertex> vertices;
+        MeshBounds bounds;
+        FaceConnectivity connectivity;
+        int lod;
+    };
+
+    // render traversal, entryFace = face of coord the search came in through (-1 at the camera)
+    // directions = faces stepped out of so far, the search never turns back towards the camera
+    struct VisibilityStep
+    {
+        ChunkCoord coord;
+        int entryFace;
+        int directions;
+    };
+
+    // column generated by a worker, waiting to be added to the maps
+    struct GeneratedColumn
+    {
+        ColumnCoord coord;
+        ChunkColumn column;
+        std::vector<std::pair<int, std::unique_ptr<Chunk>>> sections; // (section y, chunk)
+        bool fromDisk = false;
+    };
+
+    // before m_chunks, chunks hand their mesh space back to it when destroyed
+    ChunkMeshArena m_meshArena;
+
+    std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash> m_chunks;
+    std::unordered_map<ColumnCoord, ChunkColumn, ColumnCoordHash> m_columns;
+    MeshMode m_meshMode = MeshMode::Binary;
+    bool m_ambientOcclusion = true;
+
+    std::mutex m_completedMutex;
+    std::deque<CompletedMesh> m_completedMeshes;
+    std::atomic<int> m_meshesInFlight{0};
+    // last mesh request id handed out, ids only ever go up (see Chunk::setMeshRevision)
+    uint64_t m_meshRevision = 0;
+    // columns that got a new neighbour this frame, meshed once all inserts and unloads are done
+    std::unordered_set<ColumnCoord, ColumnCoordHash> m_columnsToMesh;
+    // columns whose level changed and still wait for their remesh, nearest first
+    std::deque<ColumnCoord> m_lodRemeshQueue;
+    std::unordered_set<ColumnCoord, ColumnCoordHash> m_lodRemeshQueued;
+
+    std::mutex m_generatedMutex;
+    std::vector<GeneratedColumn> m_generatedColumns;
+    std::unordered_set<ColumnCoord, ColumnCoordHash> m_pendingGeneration;
+
+    // columns that differ from what is on disk, freshly generated ones included so explored terrain is kept
+    RegionStore m_regions;
+    std::unordered_set<ColumnCoord, ColumnCoordHash> m_dirtyColumns;
+
+    // changed column that went past the unload radius, its chunks are kept here until they are written
+    struct UnloadedColumn
+    {
+        ColumnCoord coord;
+        int solidSections = 0;
+        std::vector<std::pair<int, std::unique_ptr<Chunk>>> sections;
+    };
+    // unloads are written by one save task at a time, so the region files only ever have one writer
+    // m_saveQueue waits for the next task, m_savingColumns = queued or being written, they arent loaded again until done
+    std::vector<UnloadedColumn> m_saveQueue;
+    std::unordered_set<ColumnCoord, ColumnCoordHash> m_savingColumns;
+    // written by the save task, handed back to the main thread, all under m_savedMutex
+    // m_saveDone is signalled when the task finishes, save() sleeps on it instead of spinning
+    std::mutex m_savedMutex;
+    std::condition_variable m_saveDone;
+    bool m_saveInFlight = false;
+    std::vector<ColumnCoord> m_savedColumns;
+
+    // signalled by a worker each time a snapshot is done copying and has let go of its sections (see waitForSnapshots)
+    mutable std::mutex m_snapshotMutex;
+    mutable std::condition_variable m_snapshotDone;
+
+    // chunks edited this frame, remeshed once each in update
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_dirtyChunks;
+    size_t m_editCount = 0;
+    size_t m_editRemeshCount = 0;
+
+    // flood fill queues, kept so edits dont allocate
+    std::vector<LightNode> m_lightQueue;
+    std::vector<LightRemoval> m_lightRemovals;
+    size_t m_editLightCells = 0;
+    size_t m_lastEditLightCells = 0;
+    size_t m_maxEditLightCells = 0;
+
+    // column the lod levels were last picked around
+    ColumnCoord m_lodCenter{ 0, 0 };
+
+    // load order, column offsets inside loadRadius sorted nearest first
+    std::vector<ColumnCoord> m_loadOffsets;
+    int m_loadOffsetsRadius = -1;
+
+    size_t m_visibleChunks = 0;
+    size_t m_culledChunks = 0;
+    size_t m_occludedChunks = 0;
+    std::vector<VisibilityStep> m_visibilityQueue;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_visibilityVisited;
+    size_t m_frameUploadBytes = 0;
+    size_t m_frameFenceWaits = 0;
+    size_t m_insertedColumns = 0;
+    size_t m_insertedChunks = 0;
+    size_t m_uploadedMeshes = 0;
+
+    // full rebuild stats are printed once the last mesh lands
+    bool m_reportRebuild = false;
+    std::chrono::high_resolution_clock::time_point m_rebuildStart;
+
+    // last member, its threads are joined before the queues above go away
+    TaskScheduler m_scheduler;
+
+    // terrain heights of size x size world columns from (worldX, worldZ), out[x + z * size], pure function of x,z
+    void terrainHeights(int worldX, int worldZ, int size, int* out) const;
+    // fills a column from noise, only sections with surface detail are allocated, safe to run on any thread
+    void generateColumn(ColumnCoord coord, GeneratedColumn& out) const;
+    // region file first, noise if the column was never saved, safe to run on any thread
+    void loadColumn(ColumnCoord coord, GeneratedColumn& out);
+    void saveColumns(const std::vector<ColumnCoord>& columns);
+    void saveUnloadedColumns(const std::vector<UnloadedColumn>& columns);
+    // lets columns whose save finished load again, and hands m_saveQueue to a new save task if none is running
+    void flushUnloadedColumns();
+    void rebuildAllMeshes();
+
+    Chunk* findChunk(ChunkCoord coord) const;
+    const ChunkColumn* findColumn(ColumnCoord coord) const;
+
+    // block a section that isnt allocated is made of, air if its column isnt loaded
+    BlockID implicitBlock(ChunkCoord coord) const;
+    // allocates an implicit section (filled with implicitBlock) so it can be edited
+    Chunk* materializeChunk(ChunkCoord coord);
+
+    // Lighting access over the loaded world (see VoxelWorld.cpp)
+    class WorldLightAccess;
+    // relights around a block that just changed, only cells whose light changes are visited
+    size_t updateLight(int x, int y, int z, BlockID type);
+    // columns are lit on their own, this spreads light across the faces shared with loaded neighbours
+    void blendColumnLight(ColumnCoord coord);
+    // the chunk holding local x,y,z and any neighbour whose mesh shows its light
+    void markLightDirty(ChunkCoord coord, int x, int y, int z);
+
+    // adds a finished column, whatever around it now has all 4 neighbours goes to m_columnsToMesh
+    void insertColumn(GeneratedColumn& generated);
+    void requestInsertedColumnMeshes();
+    bool hasAllNeighbors(ColumnCoord coord) const;
+    void requestColumnMeshes(ColumnCoord coord);
+
+    void streamColumns(ColumnCoord center);
+    void remeshDirtyChunks();
+
+    // current = the column's level now, it is kept inside the hysteresis margin, -1 for a new column
+    int lodForColumn(ColumnCoord coord, int current = -1) const;
+    // re-picks every column's lod around center, columns that changed level are queued for a remesh
+    void updateColumnLods(ColumnCoord center);
+    // remeshes queued level changes, at most lodRemeshBudget columns
+    void requestLodRemeshes();
+
+    // mesh box of an allocated chunk against the frustum
+    bool isMeshInFrustum(ChunkCoord coord, const Chunk& chunk, const Frustum& frustum) const;
+    // BFS over sections from the camera, draws what it reaches, returns the drawn count
+    size_t drawReachableChunks(ChunkCoord start, const Frustum& frustum, int render_distance);
+    void uploadCompletedMeshes();
 
-    void generateTerrain();
-};
\ No newline at end of file
+    void gatherSnapshotSources(ChunkCoord coord, SnapshotSources& sources) const;
+    // chunk blocks plus the 1 block shell around it from the neighbour chunks, only reads sources
+    void buildPaddedBlocks(const SnapshotSources& sources, PaddedBlocks& padded) const;
+    // looks up the sections here, a worker copies them (urgent, ahead of bulk work) and then meshes the copy
+    void requestMesh(ChunkCoord coord, bool urgent = false);
+    // chunks are changed in place, every main thread edit, insert or unload first waits here
+    // until no snapshot is still copying from the sections in [from, to]
+    void waitForSnapshots(ChunkCoord from, ChunkCoord to) const;
+};
@@ -1,6 +1,8 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <cstdlib>
+#include <string>
 #include "Shader.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -9,6 +11,7 @@
 #include <vector>
 #include "VoxelWorld.h"
 #include "Physics.h"
+#include "EntityStore.h"
 #include "InputSystem.h"
 #include "Texture.h"
 #include "OutlineRenderer.h"
@@ -23,10 +26,17 @@ extern "C"
 // globals
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
-Camera camera(glm::vec3(16.0f, 20.0f, 40.0f));
+// in columns, matches VoxelWorld::loadRadius, distant columns are drawn with coarser lod meshes
+const int RENDER_DISTANCE = 24;
+const float FAR_PLANE = RENDER_DISTANCE * CHUNK_SIZE * 1.5f;
+// entities are drawn as outlines within this many blocks, at most this many
+const float ENTITY_DRAW_DISTANCE = 32.0f;
+const int MAX_DRAWN_ENTITIES = 256;
+Camera camera(glm::vec3(16.0f, 90.0f, 40.0f));
 // time
 float delta_time = 0.0f;
 float last_frame = 0.0f;
+float last_title_update = 0.0f;
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool first_mouse = true;
@@ -72,8 +82,15 @@ int main()
     Shader outlineShader("../assets/shaders/outline.vert", "../assets/shaders/outline.frag");
 
     // system inits
-    VoxelWorld world;
+    // VOXEL_THREADS=n overrides the worker count, handy for comparing startup times
+    const char* threadsEnv = std::getenv("VOXEL_THREADS");
+    VoxelWorld world(threadsEnv ? (unsigned int)std::atoi(threadsEnv) : 0);
+    world.generateAround(camera.Position);
     Physics physics;
+    physics.respawn(world, camera); // start on the ground
+    // entities get a pool of their own so their ticks dont queue behind chunk generation
+    TaskScheduler entityThreads;
+    EntityStore entities(entityThreads);
     InputSystem input;
     input.setupCallbacks(window);
 
@@ -88,6 +105,9 @@ int main()
     shader.use(); 
     shader.setInt("TEXTURE", 0);
 
+    // block under the crosshair
+    RaycastResult target{};
+
     // loop
     while (!glfwWindowShouldClose(window))
     {
@@ -95,9 +115,11 @@ int main()
         delta_time = current_frame - last_frame;
         last_frame = current_frame;
 
-        // logic
-        input.processInput(window, delta_time, world, physics, camera);
+        // logic, clicks act on the block the outline showed last frame
+        input.processInput(window, delta_time, world, physics, camera, target, entities);
         physics.step(delta_time, world, camera);
+        entities.step(delta_time, world);
+        world.update(camera.Position);
 
         // clear render
         glClearColor(0.2f, 0.3f, 0.8f, 1.0f);
@@ -108,23 +130,61 @@ int main()
 
         // render
         shader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 projection = glm::perspective(glm::radians(camera.zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+        glm::mat4 view = camera.GetViewMatrix();
         shader.setMat4("projection", projection);
-        shader.setMat4("view", camera.GetViewMatrix());
+        shader.setMat4("view", view);
 
-        world.render(shader, camera.Position, 8);
+        // culling and upload stats in the title, refreshed twice a second
+        // only that frame's render counts the culled and occluded chunks
+        bool updateTitle = current_frame - last_title_update > 0.5f;
+        world.countCulledChunks = updateTitle;
+        world.render(projection * view, camera.Position, RENDER_DISTANCE);
 
-        // outline
-        RaycastResult target = physics.raycast(camera.Position, camera.Front, 8.0f, world);
+        if (updateTitle)
+        {
+            last_title_update = current_frame;
+            std::string title = "Voxel Engine Burden | Dev Build | chunks drawn: " + std::to_string(world.getVisibleChunkCount()) +
+                                " culled: " + std::to_string(world.getCulledChunkCount()) +
+                                " occluded: " + std::to_string(world.getOccludedChunkCount()) +
+                                " | upload: " + std::to_string(world.getFrameUploadBytes() / 1024) + " KiB" +
+                                " fence waits: " + std::to_string(world.getFrameFenceWaits()) +
+                                " | entities: " + std::to_string(entities.size()) +
+                                " tick: " + std::to_string((int)(entities.getLastTickMs() * 1000.0)) + " us";
+            glfwSetWindowTitle(window, title.c_str());
+        }
+
+        // outline, the only cast of the frame
+        target = physics.raycast(camera.Position, camera.Front, 8.0f, world);
         if (target.hit)
         {
             outlineRenderer.render(outlineShader, glm::vec3(target.x, target.y, target.z), camera.GetViewMatrix(), projection);
         }
 
+        // entity boxes near the player, one outline each so only the closest few
+        const std::vector<glm::vec3>& positions = entities.getPositions();
+        const std::vector<glm::vec3>& halfExtents = entities.getHalfExtents();
+        int drawnEntities = 0;
+        for (size_t i = 0; i < positions.size() && drawnEntities < MAX_DRAWN_ENTITIES; i++)
+        {
+            if (glm::distance(positions[i], camera.Position) > ENTITY_DRAW_DISTANCE) continue;
+            outlineRenderer.render(outlineShader, positions[i] - halfExtents[i], view, projection, halfExtents[i] * 2.0f);
+            drawnEntities++;
+        }
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    // whatever changed since load goes to the region files
+    world.save();
+    std::cout << "edits: " << world.getEditCount() << " applied, " << world.getEditRemeshCount() << " chunk remeshes" << std::endl;
+    if (world.getEditCount() > 0)
+    {
+        std::cout << "light: " << world.getEditLightCells() / world.getEditCount() << " cells relit per edit on average, "
+                  << world.getMaxEditLightCells() << " at most" << std::endl;
+    }
+
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,2 @@
 #define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-#define STB_PERLIN_IMPLEMENTATION
-#include "stb_perlin.h"
\ No newline at end of file
+#include "stb_image.h"
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "FreeListAllocator.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+// FreeListAllocator on its own, no GL, run by ctest
+// every check prints its line when it fails, any failure makes the exit code 1
+
+static int g_failures = 0;
+
+#define CHECK(condition)                                                                          \
+    do                                                                                            \
+    {                                                                                             \
+        if (!(condition))                                                                         \
+        {                                                                                         \
+            std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            g_failures++;                                                                         \
+        }                                                                                         \
+    } while (0)
+
+static void testFirstFit()
+{
+    FreeListAllocator allocator(100);
+    CHECK(allocator.allocate(10) == 0);
+    CHECK(allocator.allocate(20) == 10);
+    CHECK(allocator.allocate(10) == 30);
+
+    // the hole at 10 is the first block that fits, the tail at 40 is only used once it doesnt
+    allocator.free(10, 20);
+    CHECK(allocator.allocate(15) == 10);
+    CHECK(allocator.allocate(10) == 40);
+    CHECK(allocator.allocate(5) == 25);
+    CHECK(allocator.getUsed() == 50);
+}
+
+static void testSplit()
+{
+    FreeListAllocator allocator(64);
+    CHECK(allocator.allocate(16) == 0);
+
+    // the front is taken, the rest of the block stays free right behind it
+    CHECK(allocator.getFreeBlockCount() == 1);
+    CHECK(allocator.getLargestFreeBlock() == 48);
+    CHECK(allocator.getUsed() == 16);
+
+    // an exact fit leaves nothing behind
+    CHECK(allocator.allocate(48) == 16);
+    CHECK(allocator.getFreeBlockCount() == 0);
+    CHECK(allocator.getUsed() == 64);
+}
+
+static void testMergeOnFree()
+{
+    FreeListAllocator allocator(40);
+    size_t a = allocator.allocate(10);
+    size_t b = allocator.allocate(10);
+    size_t c = allocator.allocate(10);
+    size_t d = allocator.allocate(10);
+
+    allocator.free(a, 10);
+    allocator.free(c, 10);
+    CHECK(allocator.getFreeBlockCount() == 2);
+
+    // b sits between two free blocks and joins both
+    allocator.free(b, 10);
+    CHECK(allocator.getFreeBlockCount() == 1);
+    CHECK(allocator.getLargestFreeBlock() == 30);
+    CHECK(allocator.allocate(30) == 0);
+
+    // only a neighbour before
+    allocator.free(0, 30);
+    allocator.free(d, 10);
+    CHECK(allocator.getFreeBlockCount() == 1);
+    CHECK(allocator.getLargestFreeBlock() == 40);
+
+    // only a neighbour after
+    FreeListAllocator after(20);
+    size_t first = after.allocate(10);
+    size_t second = after.allocate(10);
+    after.free(second, 10);
+    after.free(first, 10);
+    CHECK(after.getFreeBlockCount() == 1);
+    CHECK(after.getLargestFreeBlock() == 20);
+}
+
+static void testGrow()
+{
+    FreeListAllocator allocator(32);
+    CHECK(allocator.allocate(32) == 0);
+    CHECK(allocator.allocate(8) == FreeListAllocator::INVALID);
+
+    // new space comes after the old, what was handed out keeps its offset
+    allocator.grow(64);
+    CHECK(allocator.getCapacity() == 64);
+    CHECK(allocator.getUsed() == 32);
+    CHECK(allocator.allocate(8) == 32);
+
+    // a free block at the old end merges with the added space
+    FreeListAllocator tail(32);
+    CHECK(tail.allocate(16) == 0);
+    tail.grow(64);
+    CHECK(tail.getFreeBlockCount() == 1);
+    CHECK(tail.getLargestFreeBlock() == 48);
+
+    // shrinking isnt a thing
+    tail.grow(16);
+    CHECK(tail.getCapacity() == 64);
+
+    // an empty allocator grows into its first block
+    FreeListAllocator empty;
+    CHECK(empty.allocate(1) == FreeListAllocator::INVALID);
+    empty.grow(8);
+    CHECK(empty.allocate(8) == 0);
+}
+
+static void testExhaustion()
+{
+    FreeListAllocator allocator(10);
+    CHECK(allocator.allocate(11) == FreeListAllocator::INVALID);
+    CHECK(allocator.allocate(0) == FreeListAllocator::INVALID);
+    CHECK(allocator.allocate(10) == 0);
+    CHECK(allocator.allocate(1) == FreeListAllocator::INVALID);
+    CHECK(allocator.getUsed() == 10);
+
+    // enough free space in total but no block big enough
+    FreeListAllocator fragmented(30);
+    size_t a = fragmented.allocate(10);
+    fragmented.allocate(10);
+    size_t c = fragmented.allocate(10);
+    fragmented.free(a, 10);
+    fragmented.free(c, 10);
+    CHECK(fragmented.allocate(15) == FreeListAllocator::INVALID);
+    CHECK(fragmented.getUsed() == 10);
+}
+
+static void testFreeEverything()
+{
+    const size_t CAPACITY = 4096;
+    FreeListAllocator allocator(CAPACITY);
+    std::mt19937 rng(1);
+    std::vector<std::pair<size_t, size_t>> live; // (offset, size)
+    std::vector<bool> owned(CAPACITY, false);
+
+    // random churn, no two allocations may ever overlap
+    for (int step = 0; step < 20000; step++)
+    {
+        if (live.empty() || rng() % 3 != 0)
+        {
+            size_t size = 1 + rng() % 64;
+            size_t offset = allocator.allocate(size);
+            if (offset == FreeListAllocator::INVALID) continue;
+
+            CHECK(offset + size <= CAPACITY);
+            for (size_t i = offset; i < offset + size && i < CAPACITY; i++)
+            {
+                CHECK(!owned[i]);
+                owned[i] = true;
+            }
+            live.emplace_back(offset, size);
+        }
+        else
+        {
+            size_t pick = rng() % live.size();
+            auto [offset, size] = live[pick];
+            for (size_t i = offset; i < offset + size; i++) owned[i] = false;
+            allocator.free(offset, size);
+            live[pick] = live.back();
+            live.pop_back();
+        }
+    }
+
+    size_t used = 0;
+    for (const auto& [offset, size] : live) used += size;
+    CHECK(allocator.getUsed() == used);
+
+    // back to the single block it started as, whatever order things come back in
+    std::shuffle(live.begin(), live.end(), rng);
+    for (const auto& [offset, size] : live) allocator.free(offset, size);
+    CHECK(allocator.getUsed() == 0);
+    CHECK(allocator.getFreeBlockCount() == 1);
+    CHECK(allocator.getLargestFreeBlock() == CAPACITY);
+    CHECK(allocator.allocate(CAPACITY) == 0);
+}
+
+int main()
+{
+    testFirstFit();
+    testSplit();
+    testMergeOnFree();
+    testGrow();
+    testExhaustion();
+    testFreeEverything();
+
+    if (g_failures > 0)
+    {
+        std::cout << g_failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "FreeListAllocator: all checks passed" << std::endl;
+    return 0;
+}